@@ -14,6 +14,7 @@
 
 #include "llvm/IR/Value.h"
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -152,10 +153,12 @@ namespace tuppence {
      };
 
      class FiniteWordExprAST : public ExprAST {
-         const std::string Val;
+         /// Least significant first
+         const std::vector<uint64_t> Limbs;
+         const size_t Size;
      public:
-         FiniteWordExprAST(std::string Val) :
-             ExprAST(AK_FiniteWordExpr), Val(Val) {}
+         FiniteWordExprAST(std::vector<uint64_t> Limbs, size_t Size) :
+             ExprAST(AK_FiniteWordExpr), Limbs(std::move(Limbs)), Size(Size) {}
 
  //        const std::shared_ptr<Value> eval() const override;
 
@@ -47,5 +47,7 @@ extern "C" RUNTIME_API {
     extern BuiltinFunction *BuiltinFunction_PERIOD;
     extern BuiltinFunction *BuiltinFunction_NUMERATOR;
     extern BuiltinFunction *BuiltinFunction_DENOMINATOR;
+    extern BuiltinFunction *BuiltinFunction_VECTOR;
+    extern BuiltinFunction *BuiltinFunction_LIST;
     
 }
@@ -31,6 +31,8 @@
 #define RUNTIME_API
 #endif
 
+struct FiniteWordBuilder;
+
 extern "C" RUNTIME_API {
 
     void FiniteWord_initialize();
@@ -46,6 +48,9 @@ extern "C" RUNTIME_API {
     
     FiniteWord *FiniteWord_createFromVal(size_t numBits, uint64_t val);
     
+    /// From (numBits + 63) / 64 limbs, least significant first
+    FiniteWord *FiniteWord_createFromLimbs(size_t numBits, const uint64_t *Limbs);
+    
     FiniteWord *FiniteWord_createFromFiniteWord(FiniteWord *src);
     
     FiniteWord *FiniteWord_createFromRepsWord(size_t RepetitionCount, FiniteWord *Pattern);
@@ -73,13 +78,14 @@ extern "C" RUNTIME_API {
     
     /// The width of the FiniteWord (the position of the last set bit)
     size_t FiniteWord_getBitWidth(FiniteWord *word);
+
+    /// The number of bits up to and including the highest set bit
+    size_t FiniteWord_getActiveBits(FiniteWord *word);
     
     size_t FiniteWord_countPopulation(FiniteWord *word);
     
-    
-    void FiniteWord_clearAllBits(FiniteWord *word);
-    
-    void FiniteWord_setAllBits(FiniteWord *word);
+    /// Hash of the size and bits, the same for equal words in any representation
+    uint64_t FiniteWord_hash(FiniteWord *word);
     
     
     bool FiniteWord_equal(FiniteWord *A, FiniteWord *B);
@@ -92,6 +98,18 @@ extern "C" RUNTIME_API {
     
     void FiniteWord_multiplyPeriod(FiniteWord **period, size_t factor);
     void FiniteWord_compressPeriod(FiniteWord **period);
+
+    /// Periods of the bitwise operations on periods A and B, each repeated
+    /// forever from bit 0, as their smallest repeating unit
+    /// The word of the least common multiple of their sizes is never built
+    FiniteWord *FiniteWord_periodOr(FiniteWord *A, FiniteWord *B);
+    FiniteWord *FiniteWord_periodAnd(FiniteWord *A, FiniteWord *B);
+    FiniteWord *FiniteWord_periodXor(FiniteWord *A, FiniteWord *B);
+
+    /// Sum of periods A and B, each repeated forever from bit 0, plus Carry
+    /// The low bits of the sum are Prefix, above them Period repeats forever
+    /// as its smallest repeating unit
+    void FiniteWord_periodPlus(FiniteWord *A, FiniteWord *B, uint8_t Carry, FiniteWord **Prefix, FiniteWord **Period);
     
     
     
@@ -110,6 +128,10 @@ extern "C" RUNTIME_API {
     
 //    bool operator[](unsigned bitPosition);
     uint8_t FiniteWord_getBit(FiniteWord *word, size_t bitPosition);
+
+    /// Length of the longest run at the top of transient that matches period
+    /// read down from its top bit, wrapping around to the top when it runs out
+    size_t FiniteWord_commonTopRun(FiniteWord *period, FiniteWord *transient);
     
     FiniteWord *FiniteWord_rotateRight(FiniteWord *w, size_t amount);
     FiniteWord *FiniteWord_rotateLeft(FiniteWord *w, size_t amount);
@@ -137,6 +159,9 @@ extern "C" RUNTIME_API {
     
     uint64_t FiniteWord_getRawData(FiniteWord *word);
     
+    /// Write the bits of word into (size + 63) / 64 limbs, least significant first
+    void FiniteWord_copyLimbs(FiniteWord *word, uint64_t *Limbs);
+    
     bool FiniteWord_ugt(FiniteWord *word, FiniteWord *RHS);
     
     FiniteWord *FiniteWord_lshr(FiniteWord *word, size_t shiftAmt);
@@ -186,6 +211,18 @@ extern "C" RUNTIME_API {
     FiniteWord *FiniteWord_arrayAnd(FiniteWord **Values, size_t Count);
     FiniteWord *FiniteWord_arrayXor(FiniteWord **Values, size_t Count);
 
+    /// A fresh, unshared copy of Init zero-extended to width, for use as the
+    /// Dest of the *Assign functions
+    FiniteWord *FiniteWord_createAccumulator(FiniteWord *Init, size_t width);
+
+    /// Modify Dest in place. Src is zero-extended to the size of Dest.
+    /// Dest must come from FiniteWord_createAccumulator
+    void FiniteWord_orAssign(FiniteWord *Dest, FiniteWord *Src);
+    void FiniteWord_andAssign(FiniteWord *Dest, FiniteWord *Src);
+    void FiniteWord_xorAssign(FiniteWord *Dest, FiniteWord *Src);
+    void FiniteWord_addAssign(FiniteWord *Dest, FiniteWord *Src);
+    void FiniteWord_multiplyAssign(FiniteWord *Dest, FiniteWord *Src);
+
     void FiniteWord_arrayPlus(FiniteWord **Values, size_t Count, FiniteWord **Carry, FiniteWord **Result);
     void FiniteWord_arraySubtract(FiniteWord **Values, size_t Count, FiniteWord **Hi, FiniteWord **Lo);
     void FiniteWord_arrayTimes(FiniteWord **Values, size_t Count, FiniteWord **Hi, FiniteWord **Lo);
@@ -197,10 +234,24 @@ extern "C" RUNTIME_API {
 
     FiniteWord *FiniteWord_concatenate(FiniteWord *word, FiniteWord *other);
 
+    /// Collects pieces for a single copy at the end instead of one concatenate per piece
+    /// Each appended piece goes above the pieces appended before it
+    FiniteWordBuilder *FiniteWordBuilder_create();
+    void FiniteWordBuilder_append(FiniteWordBuilder *builder, FiniteWord *bits);
+    /// The concatenation of all pieces, the builder is released
+    FiniteWord *FiniteWordBuilder_finish(FiniteWordBuilder *builder);
+
     
     
     FiniteWord *FiniteWord_gcd(FiniteWord *a, FiniteWord *b);
 
+    /// Counters of the pooled allocator behind the scratch limbs of multi-megabit
+    /// arithmetic, for diagnostics
+    void FiniteWord_allocatorStats(uint64_t *Allocations, uint64_t *Reuses, uint64_t *BytesMapped, uint64_t *BytesInUse, uint64_t *BytesCached);
+
+    /// Return the cached scratch pages to the system, e.g. after a large computation
+    void FiniteWord_allocatorTrim();
+
         
     extern FiniteWord *FiniteWord_EMPTY;
     extern FiniteWord *FiniteWord_ZERO_1BIT;
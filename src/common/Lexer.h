@@ -9,9 +9,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <istream>
+#include <vector>
 
 
 
@@ -58,6 +60,9 @@ enum Token : char {
 
 std::string stringFromToken(char);
 
+/// The binary digits of a word of Size bits stored in limbs, least significant first
+std::string binaryStringFromLimbs(const std::vector<uint64_t> &Limbs, size_t Size);
+
 
 
 namespace tuppence {
@@ -67,6 +72,7 @@ namespace tuppence {
 		char LastChar;
 		int nextChar();
 		std::string Line;
+		size_t LinePos;
 		char gettok();
 
 	public:
@@ -74,7 +80,10 @@ namespace tuppence {
 
 		std::string IdentifierStr;
         std::string IntegerWordStr;
-        std::string FiniteWordStr;
+        /// The bits of a FiniteWord literal, packed into limbs as they are read
+        /// least significant first
+        std::vector<uint64_t> FiniteWordLimbs;
+        size_t FiniteWordSize;
 
 		const std::string currentState() const;
 
@@ -15,4 +15,6 @@ extern "C" RUNTIME_API {
     TuppenceValue *Library_transient(TuppenceValue **Args, size_t Count);
     TuppenceValue *Library_numerator(TuppenceValue **Args, size_t Count);
     TuppenceValue *Library_denominator(TuppenceValue **Args, size_t Count);
+    TuppenceValue *Library_vector(TuppenceValue **Args, size_t Count);
+    TuppenceValue *Library_list(TuppenceValue **Args, size_t Count);
 }
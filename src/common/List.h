@@ -53,6 +53,9 @@ extern "C" RUNTIME_API {
     FiniteWord *List_equal(List *, List *);
     FiniteWord *List_notEqual(List *, List *);
     
+    /// Hash of the elements in order, the same for equal lists
+    uint64_t List_hash(List *list);
+    
     FiniteWord *List_arrayEqual(List **ToTest, size_t Count);
     FiniteWord *List_arrayNotEqual(List **ToTest, size_t Count);
 
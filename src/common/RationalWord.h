@@ -52,6 +52,9 @@ extern "C" RUNTIME_API {
     bool RationalWord_equal(RationalWord *A, RationalWord *B);
     bool RationalWord_notEqual(RationalWord *A, RationalWord *B);
     
+    /// Hash of the period and transient, the same for equal words
+    uint64_t RationalWord_hash(RationalWord *word);
+    
 	bool RationalWord_arrayEqual(RationalWord **ToTest, size_t Count);
     bool RationalWord_arrayNotEqual(RationalWord **ToTest, size_t Count);
     
@@ -88,6 +91,12 @@ extern "C" RUNTIME_API {
     RationalWord *RationalWord_arrayPlus(RationalWord **Values, size_t Count);
     RationalWord *RationalWord_arrayTimes(RationalWord **Values, size_t Count);
 
+    /// Prefix and smallest Period of the sum of periods A and B, each repeated
+    /// forever, plus Carry, as for FiniteWord_periodPlus but by the closed form
+    /// With CheckCost, returns false if streaming the sum is expected to be
+    /// cheaper, without computing anything at the size of the least common multiple
+    bool RationalWord_closedFormPeriodPlus(FiniteWord *A, FiniteWord *B, uint8_t Carry, bool CheckCost, FiniteWord **Prefix, FiniteWord **Period);
+
 
 
     RationalWord *RationalWord_concatenate(RationalWord *, FiniteWord *);
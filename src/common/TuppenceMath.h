@@ -25,6 +25,9 @@ uint64_t Math_lcm(uint64_t a, uint64_t b);
 
 uint64_t Math_bitLength(uint64_t n);
 
+/// Scramble the bits of n, for building hashes
+uint64_t Math_mixHash(uint64_t n);
+
 
 }
 
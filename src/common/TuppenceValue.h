@@ -35,7 +35,8 @@ enum TuppenceValueTag : uint8_t {
     RationalWordTag,
     UserFunctionTag,
     ListTag,
-    ErrorTag
+    ErrorTag,
+    WordVectorTag
 };
 
 struct BuiltinFunction;
@@ -50,6 +51,8 @@ struct UserFunction;
 
 struct List;
 
+struct WordVector;
+
 struct TuppenceValue {
     TuppenceValueTag tag;
     union {
@@ -60,6 +63,7 @@ struct TuppenceValue {
         UserFunction *userFunction;
         List *list;
         char *error;
+        WordVector *vector;
     };
 };
 
@@ -82,6 +86,8 @@ extern "C" RUNTIME_API {
     
     TuppenceValue *Value_createFromBuiltinFunction(BuiltinFunction *);
     
+    TuppenceValue *Value_createFromWordVector(WordVector *);
+    
     
     
     
@@ -134,6 +140,8 @@ extern "C" RUNTIME_API {
     extern TuppenceValue *TuppenceValue_PERIOD;
     extern TuppenceValue *TuppenceValue_NUMERATOR;
     extern TuppenceValue *TuppenceValue_DENOMINATOR;
+    extern TuppenceValue *TuppenceValue_VECTOR;
+    extern TuppenceValue *TuppenceValue_LIST;
 }
 
 
@@ -0,0 +1,82 @@
+//===------ WordVector.h - WordVector class definition --------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "TuppenceValue.h"
+
+#include <cstddef> // for size_t
+
+#ifdef _WIN32
+#    if RUNTIME_DLL
+#    define RUNTIME_API __declspec(dllexport)
+#    else
+#    define RUNTIME_API __declspec(dllimport)
+#endif
+#else
+#define RUNTIME_API
+#endif
+
+//
+// A WordVector packs many FiniteWords of the same size, and applies each
+// operation to all of them at once.
+//
+// The words are stored bit-sliced: slice b holds bit b of every word, one
+// word per bit lane, 64 words to a limb. An elementwise bitwise operation is
+// then one pass over the limbs, and addition, comparison and population count
+// are circuits run on 64 words per instruction.
+//
+
+extern "C" RUNTIME_API {
+
+    /// Count > 0, and the words all have the same size
+    WordVector *WordVector_createFromWords(FiniteWord **Words, size_t Count);
+
+    /// null unless the list is not empty and only holds FiniteWords of the same size
+    WordVector *WordVector_createFromList(List *list);
+
+    List *WordVector_toList(WordVector *vector);
+
+
+    int32_t WordVector_newString(WordVector *vector, char **str);
+
+
+    /// The size of each word
+    size_t WordVector_width(WordVector *vector);
+
+    /// The number of words
+    size_t WordVector_count(WordVector *vector);
+
+    FiniteWord *WordVector_get(WordVector *vector, size_t idx);
+
+
+    //
+    // Elementwise operations, the vectors all have the same width and count
+    //
+
+    WordVector *WordVector_arrayOr(WordVector **Values, size_t Count);
+    WordVector *WordVector_arrayAnd(WordVector **Values, size_t Count);
+    WordVector *WordVector_arrayXor(WordVector **Values, size_t Count);
+
+    /// Same results as FiniteWord_arrayPlus, for each word
+    void WordVector_arrayPlus(WordVector **Values, size_t Count, WordVector **Hi, WordVector **Lo);
+
+    /// Same results as FiniteWord_arraySubtract, for each word
+    void WordVector_arraySubtract(WordVector **Values, size_t Count, WordVector **Hi, WordVector **Lo);
+
+    /// The number of set bits of each word
+    WordVector *WordVector_countPopulation(WordVector *vector);
+
+    /// 1-bit words, set where all of the words are equal
+    WordVector *WordVector_arrayEqual(WordVector **ToTest, size_t Count);
+
+    /// 1-bit words, set where no two of the words are equal
+    WordVector *WordVector_arrayNotEqual(WordVector **ToTest, size_t Count);
+
+}
@@ -63,7 +63,7 @@ const std::string BinaryExprAST::string() const {
 }
 
 const std::string FiniteWordExprAST::string() const {
-    return "`" + Val + "`";
+    return "`" + binaryStringFromLimbs(Limbs, Size) + "`";
 }
 
 const std::string IntegerWordExprAST::string() const {
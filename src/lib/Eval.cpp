@@ -57,6 +57,7 @@ llvm::IntegerType *eval::types::SizeTTy;
 llvm::PointerType *eval::types::VoidPtrTy;
 llvm::PointerType *eval::types::CharPtrTy;
 llvm::PointerType *eval::types::Int8PtrTy;
+llvm::PointerType *eval::types::Int64PtrTy;
 
 llvm::PointerType *eval::types::FiniteWordPtrTy;
 llvm::PointerType *eval::types::RationalWordPtrTy;
@@ -75,6 +76,7 @@ std::map<std::string, TuppenceValue**> eval::NamedValues;
 llvm::Function *getRuntimeFunction(std::string Name);
 
 llvm::Constant* AddGlobalString(std::string S, std::string Name);
+llvm::Constant* AddGlobalLimbs(const std::vector<uint64_t> &Limbs, std::string Name);
 llvm::Value *LogError(std::string ErrStr);
 
 llvm::GlobalVariable *createGlobal(std::string Name, TuppenceValue **V);
@@ -388,6 +390,26 @@ llvm::Constant* AddGlobalString(std::string S, std::string Name) {
     return const_ptr_5;
 }
 
+/// Constant array of the limbs, as a pointer to the first limb
+llvm::Constant* AddGlobalLimbs(const std::vector<uint64_t> &Limbs, std::string Name) {
+    
+    auto LimbsTy = llvm::ArrayType::get(eval::types::Int64Ty, Limbs.size());
+    
+    llvm::GlobalVariable* gvar_array__limbs = new llvm::GlobalVariable(/*Module=*/*eval::TheModule,
+                                                                       /*Type=*/LimbsTy,
+                                                                       /*isConstant=*/true,
+                                                                       /*Linkage=*/llvm::GlobalValue::PrivateLinkage,
+                                                                       /*Initializer=*/llvm::ConstantDataArray::get(eval::TheContext, llvm::ArrayRef<uint64_t>(Limbs)),
+                                                                       /*Name=*/Name);
+    gvar_array__limbs->setAlignment(8);
+    
+    std::vector<llvm::Constant*> indices;
+    llvm::ConstantInt* const_int64_0 = llvm::ConstantInt::get(eval::TheContext, llvm::APInt(64, 0));
+    indices.push_back(const_int64_0);
+    indices.push_back(const_int64_0);
+    return llvm::ConstantExpr::getGetElementPtr(LimbsTy, gvar_array__limbs, indices);
+}
+
 llvm::Value *LogError(std::string ErrStr) {
     
     auto StrConst = AddGlobalString(ErrStr, "errorString");
@@ -401,12 +423,10 @@ llvm::Value *LogError(std::string ErrStr) {
     return eval::Builder.CreateCall(Value_createFromError, ArgsForCall, "value");
 }
 
-llvm::Value *createFiniteWordValue(std::string Val) {
-
-    auto StrConst = AddGlobalString(Val, "finiteWordString");
+llvm::Value *createFiniteWordValue(const std::vector<uint64_t> &Limbs, size_t Size) {
     
     llvm::Value *FiniteWordCall;
-    if (Val.empty()) {
+    if (Size == 0) {
         
         llvm::Function *FiniteWord_createEmpty = getRuntimeFunction("FiniteWord_createEmpty");
         assert(FiniteWord_createEmpty);
@@ -417,16 +437,19 @@ llvm::Value *createFiniteWordValue(std::string Val) {
         
     } else {
         
-        auto NumBits = llvm::ConstantInt::get(eval::TheContext, llvm::APInt(sizeof(size_t) * CHAR_BIT, Val.size()));
+        // the lexer already packed the bits, so the word is one copy of the limbs
+        auto LimbsConst = AddGlobalLimbs(Limbs, "finiteWordLimbs");
+        
+        auto NumBits = llvm::ConstantInt::get(eval::TheContext, llvm::APInt(sizeof(size_t) * CHAR_BIT, Size));
         
         std::vector<llvm::Value *> ArgsV;
         ArgsV.push_back(NumBits);
-        ArgsV.push_back(StrConst);
+        ArgsV.push_back(LimbsConst);
         
-        llvm::Function *FiniteWord_createFromBinaryString = getRuntimeFunction("FiniteWord_createFromBinaryString");
-        assert(FiniteWord_createFromBinaryString);
+        llvm::Function *FiniteWord_createFromLimbs = getRuntimeFunction("FiniteWord_createFromLimbs");
+        assert(FiniteWord_createFromLimbs);
         
-        FiniteWordCall = eval::Builder.CreateCall(FiniteWord_createFromBinaryString, ArgsV, "finiteWord");
+        FiniteWordCall = eval::Builder.CreateCall(FiniteWord_createFromLimbs, ArgsV, "finiteWord");
     }
     
     llvm::Value *ValueCall;
@@ -444,7 +467,7 @@ llvm::Value *createFiniteWordValue(std::string Val) {
 }
 
 llvm::Value *FiniteWordExprAST::codegen() {
-    return createFiniteWordValue(Val);
+    return createFiniteWordValue(Limbs, Size);
 }
 
 llvm::Value *IdentifierExprAST::codegen() {
@@ -57,6 +57,7 @@ namespace tuppence {
             extern llvm::PointerType *VoidPtrTy;
             extern llvm::PointerType *CharPtrTy;
             extern llvm::PointerType *Int8PtrTy;
+            extern llvm::PointerType *Int64PtrTy;
             
             extern llvm::PointerType *FiniteWordPtrTy;
             extern llvm::PointerType *RationalWordPtrTy;
@@ -73,6 +73,7 @@ void eval::InitializeTypes() {
     eval::types::VoidPtrTy = llvm::PointerType::get(eval::types::Int8Ty, 0);
     eval::types::CharPtrTy = llvm::PointerType::get(eval::types::CharTy, 0);
     eval::types::Int8PtrTy = llvm::PointerType::get(eval::types::Int8Ty, 0);
+    eval::types::Int64PtrTy = llvm::PointerType::get(eval::types::Int64Ty, 0);
     
     eval::types::TuppenceValueTy = llvm::StructType::create(eval::TheContext, "TuppenceValue");
     std::vector<llvm::Type*> members;
@@ -114,6 +115,18 @@ void eval::InitializeRuntimeFunctions() {
         RuntimeFunctionTypes["FiniteWord_createFromBinaryString"] = FT;
     }
     
+    {
+        // FiniteWord *FiniteWord_createFromLimbs(size_t numBits, const uint64_t *Limbs);
+        
+        std::vector<llvm::Type *> ParamTys;
+        ParamTys.push_back(eval::types::SizeTTy);
+        ParamTys.push_back(eval::types::Int64PtrTy);
+        auto RetTy = eval::types::FiniteWordPtrTy;
+        llvm::FunctionType *FT = llvm::FunctionType::get(RetTy, ParamTys, false);
+        
+        RuntimeFunctionTypes["FiniteWord_createFromLimbs"] = FT;
+    }
+    
     {
         // FiniteWordImpl *FiniteWord_createEmpty();
         
@@ -341,5 +354,9 @@ void eval::InitializeNamedValues() {
     eval::NamedValues["numerator"] = &TuppenceValue_NUMERATOR;
     
     eval::NamedValues["denominator"] = &TuppenceValue_DENOMINATOR;
+    
+    eval::NamedValues["vector"] = &TuppenceValue_VECTOR;
+    
+    eval::NamedValues["list"] = &TuppenceValue_LIST;
 }
 
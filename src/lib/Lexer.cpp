@@ -14,6 +14,8 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+
 using namespace tuppence;
 
 char tuppence::LogLexerError(std::string Msg) {
@@ -22,7 +24,7 @@ char tuppence::LogLexerError(std::string Msg) {
 }
 
 Lexer::Lexer(std::istream &In) :
-	In(In), LastChar('\0') {}
+	In(In), LastChar('\0'), LinePos(0), FiniteWordSize(0) {}
 
 std::string stringFromToken(char Op) {
     switch (Op) {
@@ -62,27 +64,39 @@ std::string stringFromToken(char Op) {
     }
 }
 
+std::string binaryStringFromLimbs(const std::vector<uint64_t> &Limbs, size_t Size) {
+    std::string Str(Size, '0');
+    for (size_t i = 0; i < Size; i++) {
+        if ((Limbs[i / 64] >> (i % 64)) & 1) {
+            Str[Size - 1 - i] = '1';
+        }
+    }
+    return Str;
+}
+
 const std::string Lexer::currentState() const {
 	switch (CurTok) {
 	case tok_identifier: return IdentifierStr;
 	case tok_integerword: return IntegerWordStr;
-	case tok_finiteword: return FiniteWordStr;
+	case tok_finiteword: return binaryStringFromLimbs(FiniteWordLimbs, FiniteWordSize);
 	default: return stringFromToken(CurTok);
 	}
 }
 
 int Lexer::nextChar() {
-	if (Line.empty()) {
+	// keep a position instead of erasing the front of Line, which is quadratic for long lines
+	if (LinePos == Line.size()) {
 		std::getline(In, Line);
         
 		if (!In.good()) {
+			Line.clear();
+			LinePos = 0;
 			return EOF;
 		}
-		Line = Line + '\n';
+		Line += '\n';
+		LinePos = 0;
 	}
-	auto first = Line.at(0);
-	Line.erase(0, 1);
-	return first;
+	return Line[LinePos++];
 }
 
 char Lexer::gettok() {
@@ -148,16 +162,35 @@ char Lexer::gettok() {
 	}
 
 	if (LastChar == '`') {
-        FiniteWordStr.clear();
+        FiniteWordLimbs.clear();
+        FiniteWordSize = 0;
         
 		LastChar = nextChar();
 		while (LastChar == ' ') {
 			LastChar = nextChar();
 		}
+		// pack 64 digits at a time, most significant limb first
+		uint64_t Limb = 0;
 		while (LastChar == '0' || LastChar == '1') {
-			FiniteWordStr += LastChar;
+			Limb = (Limb << 1) | (uint64_t)(LastChar == '1');
+			FiniteWordSize++;
+			if (FiniteWordSize % 64 == 0) {
+				FiniteWordLimbs.push_back(Limb);
+				Limb = 0;
+			}
 			LastChar = nextChar();
 		}
+		// reorder least significant first, and shift the full limbs up past the
+		// Remainder bits that were read last
+		std::reverse(FiniteWordLimbs.begin(), FiniteWordLimbs.end());
+		auto Remainder = FiniteWordSize % 64;
+		if (Remainder != 0) {
+			FiniteWordLimbs.push_back(0);
+			for (size_t i = FiniteWordLimbs.size() - 1; i > 0; i--) {
+				FiniteWordLimbs[i] = (FiniteWordLimbs[i] << Remainder) | (FiniteWordLimbs[i - 1] >> (64 - Remainder));
+			}
+			FiniteWordLimbs[0] = (FiniteWordLimbs[0] << Remainder) | Limb;
+		}
 		if (LastChar == '`') {
 			LastChar = nextChar();
 			return tok_finiteword;
@@ -79,7 +79,7 @@ const std::shared_ptr<IntegerWordExprAST> Parser::ParseIntegerWordExpr() {
 
 const std::shared_ptr<FiniteWordExprAST> Parser::ParseFiniteWordExpr() {
 	assert(Lex.CurTok == tok_finiteword && "Expected tok_finiteword");
-	auto Result = std::make_shared<FiniteWordExprAST>(Lex.FiniteWordStr);
+	auto Result = std::make_shared<FiniteWordExprAST>(std::move(Lex.FiniteWordLimbs), Lex.FiniteWordSize);
 	Lex.readNextToken(); // consume the `
 	return Result;
 }
@@ -0,0 +1,322 @@
+//===------ BitKernels.cpp ------------------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BitKernels.h"
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MathExtras.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BITKERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC and Clang need each function to opt in to the instruction set it uses,
+// so that the rest of the runtime still runs on any x86 CPU
+#if defined(__GNUC__) || defined(__clang__)
+#define BITKERNELS_TARGET(Features) __attribute__((target(Features)))
+#else
+#define BITKERNELS_TARGET(Features)
+#endif
+
+//
+// Portable scalar kernels
+//
+
+static void scalarAnd(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    for (size_t i = 0; i < Count; i++) {
+        Dest[i] = A[i] & B[i];
+    }
+}
+
+static void scalarOr(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    for (size_t i = 0; i < Count; i++) {
+        Dest[i] = A[i] | B[i];
+    }
+}
+
+static void scalarXor(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    for (size_t i = 0; i < Count; i++) {
+        Dest[i] = A[i] ^ B[i];
+    }
+}
+
+static void scalarNot(uint64_t *Dest, const uint64_t *A, size_t Count) {
+    for (size_t i = 0; i < Count; i++) {
+        Dest[i] = ~A[i];
+    }
+}
+
+static size_t scalarCountPopulation(const uint64_t *A, size_t Count) {
+    size_t Population = 0;
+    for (size_t i = 0; i < Count; i++) {
+        Population += llvm::countPopulation(A[i]);
+    }
+    return Population;
+}
+
+#if BITKERNELS_X86
+
+//
+// SSE2 kernels, 2 limbs per vector
+//
+
+BITKERNELS_TARGET("sse2")
+static void sse2And(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 2 <= Count; i += 2) {
+        auto VA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(A + i));
+        auto VB = _mm_loadu_si128(reinterpret_cast<const __m128i *>(B + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(Dest + i), _mm_and_si128(VA, VB));
+    }
+    scalarAnd(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("sse2")
+static void sse2Or(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 2 <= Count; i += 2) {
+        auto VA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(A + i));
+        auto VB = _mm_loadu_si128(reinterpret_cast<const __m128i *>(B + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(Dest + i), _mm_or_si128(VA, VB));
+    }
+    scalarOr(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("sse2")
+static void sse2Xor(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 2 <= Count; i += 2) {
+        auto VA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(A + i));
+        auto VB = _mm_loadu_si128(reinterpret_cast<const __m128i *>(B + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(Dest + i), _mm_xor_si128(VA, VB));
+    }
+    scalarXor(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("sse2")
+static void sse2Not(uint64_t *Dest, const uint64_t *A, size_t Count) {
+    auto Ones = _mm_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 2 <= Count; i += 2) {
+        auto VA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(A + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(Dest + i), _mm_xor_si128(VA, Ones));
+    }
+    scalarNot(Dest + i, A + i, Count - i);
+}
+
+/// Hardware popcnt, which is separate from SSE2 but present on every CPU that has AVX2
+BITKERNELS_TARGET("popcnt")
+static size_t popcntCountPopulation(const uint64_t *A, size_t Count) {
+    size_t Population = 0;
+    for (size_t i = 0; i < Count; i++) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        Population += static_cast<size_t>(_mm_popcnt_u64(A[i]));
+#else
+        // inlined here, so it compiles to popcnt
+        Population += llvm::countPopulation(A[i]);
+#endif
+    }
+    return Population;
+}
+
+//
+// AVX2 kernels, 4 limbs per vector
+//
+
+BITKERNELS_TARGET("avx2")
+static void avx2And(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        auto VA = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(A + i));
+        auto VB = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(B + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(Dest + i), _mm256_and_si256(VA, VB));
+    }
+    scalarAnd(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("avx2")
+static void avx2Or(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        auto VA = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(A + i));
+        auto VB = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(B + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(Dest + i), _mm256_or_si256(VA, VB));
+    }
+    scalarOr(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("avx2")
+static void avx2Xor(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        auto VA = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(A + i));
+        auto VB = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(B + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(Dest + i), _mm256_xor_si256(VA, VB));
+    }
+    scalarXor(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("avx2")
+static void avx2Not(uint64_t *Dest, const uint64_t *A, size_t Count) {
+    auto Ones = _mm256_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        auto VA = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(A + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(Dest + i), _mm256_xor_si256(VA, Ones));
+    }
+    scalarNot(Dest + i, A + i, Count - i);
+}
+
+/// Nibble lookup with vpshufb, summed per lane with vpsadbw
+BITKERNELS_TARGET("avx2,popcnt")
+static size_t avx2CountPopulation(const uint64_t *A, size_t Count) {
+    auto Lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                   0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    auto LowNibbles = _mm256_set1_epi8(0x0f);
+    auto Zero = _mm256_setzero_si256();
+    auto Accumulate = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        auto V = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(A + i));
+        auto Lo = _mm256_and_si256(V, LowNibbles);
+        auto Hi = _mm256_and_si256(_mm256_srli_epi16(V, 4), LowNibbles);
+        auto Bytes = _mm256_add_epi8(_mm256_shuffle_epi8(Lookup, Lo), _mm256_shuffle_epi8(Lookup, Hi));
+        Accumulate = _mm256_add_epi64(Accumulate, _mm256_sad_epu8(Bytes, Zero));
+    }
+    alignas(32) uint64_t Lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(Lanes), Accumulate);
+    size_t Population = static_cast<size_t>(Lanes[0] + Lanes[1] + Lanes[2] + Lanes[3]);
+    return Population + popcntCountPopulation(A + i, Count - i);
+}
+
+//
+// AVX-512 kernels, 8 limbs per vector
+//
+
+BITKERNELS_TARGET("avx512f")
+static void avx512And(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 8 <= Count; i += 8) {
+        auto VA = _mm512_loadu_si512(A + i);
+        auto VB = _mm512_loadu_si512(B + i);
+        _mm512_storeu_si512(Dest + i, _mm512_and_si512(VA, VB));
+    }
+    scalarAnd(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("avx512f")
+static void avx512Or(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 8 <= Count; i += 8) {
+        auto VA = _mm512_loadu_si512(A + i);
+        auto VB = _mm512_loadu_si512(B + i);
+        _mm512_storeu_si512(Dest + i, _mm512_or_si512(VA, VB));
+    }
+    scalarOr(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("avx512f")
+static void avx512Xor(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count) {
+    size_t i = 0;
+    for (; i + 8 <= Count; i += 8) {
+        auto VA = _mm512_loadu_si512(A + i);
+        auto VB = _mm512_loadu_si512(B + i);
+        _mm512_storeu_si512(Dest + i, _mm512_xor_si512(VA, VB));
+    }
+    scalarXor(Dest + i, A + i, B + i, Count - i);
+}
+
+BITKERNELS_TARGET("avx512f")
+static void avx512Not(uint64_t *Dest, const uint64_t *A, size_t Count) {
+    auto Ones = _mm512_set1_epi64(-1);
+    size_t i = 0;
+    for (; i + 8 <= Count; i += 8) {
+        auto VA = _mm512_loadu_si512(A + i);
+        _mm512_storeu_si512(Dest + i, _mm512_xor_si512(VA, Ones));
+    }
+    scalarNot(Dest + i, A + i, Count - i);
+}
+
+/// Only on CPUs with the VPOPCNTDQ extension, otherwise AVX2 is used for population
+BITKERNELS_TARGET("avx512f,avx512vpopcntdq,popcnt")
+static size_t avx512CountPopulation(const uint64_t *A, size_t Count) {
+    auto Accumulate = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 8 <= Count; i += 8) {
+        auto V = _mm512_loadu_si512(A + i);
+        Accumulate = _mm512_add_epi64(Accumulate, _mm512_popcnt_epi64(V));
+    }
+    alignas(64) uint64_t Lanes[8];
+    _mm512_store_si512(Lanes, Accumulate);
+    size_t Population = 0;
+    for (size_t j = 0; j < 8; j++) {
+        Population += static_cast<size_t>(Lanes[j]);
+    }
+    return Population + popcntCountPopulation(A + i, Count - i);
+}
+
+#endif // BITKERNELS_X86
+
+BitKernels_BinaryFunction BitKernels_and = scalarAnd;
+BitKernels_BinaryFunction BitKernels_or = scalarOr;
+BitKernels_BinaryFunction BitKernels_xor = scalarXor;
+BitKernels_UnaryFunction BitKernels_not = scalarNot;
+BitKernels_PopulationFunction BitKernels_countPopulation = scalarCountPopulation;
+
+static const char *BitKernelsName = "scalar";
+
+void BitKernels_initialize() {
+#if BITKERNELS_X86
+    llvm::StringMap<bool> Features;
+    if (!llvm::sys::getHostCPUFeatures(Features)) {
+        return;
+    }
+
+    if (Features.lookup("popcnt")) {
+        BitKernels_countPopulation = popcntCountPopulation;
+    }
+
+    if (Features.lookup("avx512f")) {
+        BitKernels_and = avx512And;
+        BitKernels_or = avx512Or;
+        BitKernels_xor = avx512Xor;
+        BitKernels_not = avx512Not;
+        if (Features.lookup("avx512vpopcntdq") && Features.lookup("popcnt")) {
+            BitKernels_countPopulation = avx512CountPopulation;
+        }
+        else if (Features.lookup("avx2") && Features.lookup("popcnt")) {
+            BitKernels_countPopulation = avx2CountPopulation;
+        }
+        BitKernelsName = "avx512";
+    }
+    else if (Features.lookup("avx2")) {
+        BitKernels_and = avx2And;
+        BitKernels_or = avx2Or;
+        BitKernels_xor = avx2Xor;
+        BitKernels_not = avx2Not;
+        if (Features.lookup("popcnt")) {
+            BitKernels_countPopulation = avx2CountPopulation;
+        }
+        BitKernelsName = "avx2";
+    }
+    else if (Features.lookup("sse2")) {
+        BitKernels_and = sse2And;
+        BitKernels_or = sse2Or;
+        BitKernels_xor = sse2Xor;
+        BitKernels_not = sse2Not;
+        BitKernelsName = "sse2";
+    }
+#endif
+}
+
+const char *BitKernels_name() {
+    return BitKernelsName;
+}
@@ -0,0 +1,37 @@
+//===------ BitKernels.h - Word-parallel kernels on limb arrays -----------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef> // for size_t
+#include <cstdint>
+
+//
+// Bitwise kernels over arrays of 64-bit limbs, used by FiniteWord for wide words.
+//
+// The kernels are function pointers that BitKernels_initialize points at the
+// best implementation for the host CPU (AVX-512, AVX2, SSE2, or portable scalar).
+// Dest may be the same array as A or B.
+//
+
+typedef void (*BitKernels_BinaryFunction)(uint64_t *Dest, const uint64_t *A, const uint64_t *B, size_t Count);
+typedef void (*BitKernels_UnaryFunction)(uint64_t *Dest, const uint64_t *A, size_t Count);
+typedef size_t (*BitKernels_PopulationFunction)(const uint64_t *A, size_t Count);
+
+extern BitKernels_BinaryFunction BitKernels_and;
+extern BitKernels_BinaryFunction BitKernels_or;
+extern BitKernels_BinaryFunction BitKernels_xor;
+extern BitKernels_UnaryFunction BitKernels_not;
+extern BitKernels_PopulationFunction BitKernels_countPopulation;
+
+/// Select kernels for the host CPU
+void BitKernels_initialize();
+
+/// Name of the selected instruction set, for diagnostics
+const char *BitKernels_name();
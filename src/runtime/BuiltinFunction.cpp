@@ -29,6 +29,8 @@ BuiltinFunction *BuiltinFunction_TRANSIENT;
 BuiltinFunction *BuiltinFunction_PERIOD;
 BuiltinFunction *BuiltinFunction_NUMERATOR;
 BuiltinFunction *BuiltinFunction_DENOMINATOR;
+BuiltinFunction *BuiltinFunction_VECTOR;
+BuiltinFunction *BuiltinFunction_LIST;
 
 void BuiltinFunction_initialize() {
     BuiltinFunction_PRINT = BuiltinFunction_createFromName("print", Library_print);
@@ -39,6 +41,8 @@ void BuiltinFunction_initialize() {
     BuiltinFunction_PERIOD = BuiltinFunction_createFromName("period", Library_period);
     BuiltinFunction_NUMERATOR = BuiltinFunction_createFromName("numerator", Library_numerator);
     BuiltinFunction_DENOMINATOR = BuiltinFunction_createFromName("denominator", Library_denominator);
+    BuiltinFunction_VECTOR = BuiltinFunction_createFromName("vector", Library_vector);
+    BuiltinFunction_LIST = BuiltinFunction_createFromName("list", Library_list);
 }
 
 
@@ -9,23 +9,78 @@
 
 #include "../common/FiniteWord.h"
 
+#include "BitKernels.h"
+#include "FixedWord.h"
+#include "LimbAllocator.h"
+#include "LimbArithmetic.h"
+#include "LimbDivide.h"
+#include "LimbGcd.h"
+#include "LimbMultiply.h"
+
 // #include "runtime/Runtime.h"
 #include "../common/TuppenceMath.h"
 
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/SwapByteOrder.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 
+/// Words of at most SMALL_WORD_BITS bits keep their bits inline in Small and
+/// never touch Val. Larger words are stored in Val, or are views.
+static const size_t SMALL_WORD_BITS = 64;
+
+/// Words of at most CACHED_WORD_BITS bits are interned, so 1-bit comparison
+/// results, carries, and the like never allocate.
+static const size_t CACHED_WORD_BITS = 8;
+
+/// Words of at least SPARSE_MIN_BITS bits with fewer than one set bit per
+/// SPARSE_BITS_PER_SET_BIT bits are kept as a list of set bit positions
+static const size_t SPARSE_MIN_BITS = 4096;
+static const size_t SPARSE_BITS_PER_SET_BIT = 256;
+
 //class FiniteWordImpl : public gc {
 struct FiniteWord {
     size_t Size;
+    uint64_t Small;
     llvm::APInt Val;
     
-    FiniteWord() {}
+    /// A view is the Size bits of Base starting at bit Offset, with Val not yet
+    /// filled in. Base is never itself a view. Words are never freed, so Base
+    /// stays valid for as long as the view does.
+    FiniteWord *Base;
+    size_t Offset;
+    
+    /// A sparse word has the sorted positions of its set bits here, and Val is
+    /// only filled in when an operation needs limbs
+    const std::vector<uint64_t> *SetBits;
+    
+    /// A repeat is Pattern repeated Size / Pattern->Size times, and Val is only
+    /// filled in when an operation needs limbs. Pattern is never itself a repeat.
+    FiniteWord *Pattern;
+    
+    /// FiniteWord_hash, or 0 before it is first asked for
+    /// Cleared by the ...Assign functions, which modify accumulators in place
+    uint64_t Hash;
+    
+    FiniteWord() :
+        Base(nullptr),
+        Offset(0),
+        SetBits(nullptr),
+        Pattern(nullptr),
+        Hash(0) {}
     
 //    void* operator new(size_t sz) {
 //        llvm::outs() << "operator new" << "\n";
@@ -38,12 +93,54 @@ struct FiniteWord {
 //        ::operator delete(p);
 //    }
     
+    FiniteWord(size_t Size, uint64_t Small) :
+        Size(Size),
+        Small(Small),
+        Base(nullptr),
+        Offset(0),
+        SetBits(nullptr),
+        Pattern(nullptr),
+        Hash(0) {}
+    
     FiniteWord(size_t Size, llvm::APInt Val) :
         Size(Size),
-        Val(Val) {
+        Small(0),
+        Val(Val),
+        Base(nullptr),
+        Offset(0),
+        SetBits(nullptr),
+        Pattern(nullptr),
+        Hash(0) {
 //        llvm::outs() << "creating FiniteWordImpl\n";
     }
     
+    FiniteWord(size_t Size, FiniteWord *Base, size_t Offset) :
+        Size(Size),
+        Small(0),
+        Base(Base),
+        Offset(Offset),
+        SetBits(nullptr),
+        Pattern(nullptr),
+        Hash(0) {}
+    
+    FiniteWord(size_t Size, const std::vector<uint64_t> *SetBits) :
+        Size(Size),
+        Small(0),
+        Base(nullptr),
+        Offset(0),
+        SetBits(SetBits),
+        Pattern(nullptr),
+        Hash(0) {}
+    
+    FiniteWord(size_t Size, FiniteWord *Pattern) :
+        Size(Size),
+        Small(0),
+        Base(nullptr),
+        Offset(0),
+        SetBits(nullptr),
+        Pattern(Pattern),
+        Hash(0) {}
+    
 //    ~FiniteWordImpl() {
 //        llvm::outs() << "destroying FiniteWordImpl\n";
 //    }
@@ -52,29 +149,291 @@ struct FiniteWord {
 
 const std::string FiniteWord_bits(FiniteWord *word);
 
+FiniteWord *FiniteWord_trunc(FiniteWord *word, size_t truncAmt);
+
+static bool hasPeriod(FiniteWord *word, size_t Distance);
+
 
 
 FiniteWord *FiniteWord_EMPTY;
 FiniteWord *FiniteWord_ZERO_1BIT;
 FiniteWord *FiniteWord_ONE_1BIT;
 
+/// indexed by (1 << Size) + Bits
+static FiniteWord *SmallWordCache[2 << CACHED_WORD_BITS];
+
 
 void FiniteWord_initialize() {
+    BitKernels_initialize();
+    
     FiniteWord_EMPTY = FiniteWord_createEmpty();
     FiniteWord_ZERO_1BIT = FiniteWord_createFromBool((bool)0);
     FiniteWord_ONE_1BIT = FiniteWord_createFromBool((bool)1);
 }
 
 
+static inline bool isSmall(FiniteWord *word) {
+    return word->Size <= SMALL_WORD_BITS;
+}
+
+/// Mask of the low Size bits, Size <= 64
+static inline uint64_t lowMask(size_t Size) {
+    return Size == 0 ? 0 : (~(uint64_t)0 >> (SMALL_WORD_BITS - Size));
+}
+
+/// Size <= 64, Bits is masked to Size
+FiniteWord *FiniteWord_createFromSmall(size_t Size, uint64_t Bits) {
+    assert(Size <= SMALL_WORD_BITS && "Size too large for small word");
+    
+    Bits &= lowMask(Size);
+    
+    if (Size <= CACHED_WORD_BITS) {
+        auto &Cached = SmallWordCache[((size_t)1 << Size) + Bits];
+        if (!Cached) {
+            Cached = new FiniteWord(Size, Bits);
+        }
+        return Cached;
+    }
+    
+    return new FiniteWord(Size, Bits);
+}
+
+static void materialize(FiniteWord *word);
+
+/// Bits of word as an APInt, also for small words
+/// The empty word gives the 1-bit 0, as APInt has no 0-bit value
+llvm::APInt FiniteWord_toAPInt(FiniteWord *word) {
+    if (word->Size == 0) {
+        return llvm::APInt();
+    }
+    if (isSmall(word)) {
+        return llvm::APInt(static_cast<unsigned int>(word->Size), word->Small, false);
+    }
+    materialize(word);
+    return word->Val;
+}
+
+/// Number of 64-bit limbs needed to hold Size bits
+static inline size_t numLimbs(size_t Size) {
+    return (Size + SMALL_WORD_BITS - 1) / SMALL_WORD_BITS;
+}
+
+/// Mask of the bits of the top limb that belong to a word of Size bits
+static inline uint64_t topLimbMask(size_t Size) {
+    return lowMask(Size - (numLimbs(Size) - 1) * SMALL_WORD_BITS);
+}
+
+/// Limbs of word, least significant first
+/// Only write through them for words that are not shared, i.e. accumulators
+/// and fresh results
+static inline uint64_t *getLimbs(FiniteWord *word) {
+    if (isSmall(word)) {
+        return &word->Small;
+    }
+    materialize(word);
+    return const_cast<uint64_t *>(word->Val.getRawData());
+}
+
+/// Count bits of Src starting at SrcOffset, as one limb, Count <= 64
+/// Limbs past SrcLimbs are treated as 0
+static inline uint64_t readBits(const uint64_t *Src, size_t SrcLimbs, size_t SrcOffset, size_t Count) {
+    auto Index = SrcOffset / SMALL_WORD_BITS;
+    auto Shift = SrcOffset % SMALL_WORD_BITS;
+    auto Bits = Src[Index] >> Shift;
+    if (Shift != 0 && Index + 1 < SrcLimbs) {
+        Bits |= Src[Index + 1] << (SMALL_WORD_BITS - Shift);
+    }
+    return Bits & lowMask(Count);
+}
+
+/// OR Count bits of Src starting at SrcOffset into Dest starting at DestOffset
+/// Dest is normally zero there. The two ranges must not overlap.
+static void copyBits(uint64_t *Dest, size_t DestOffset, const uint64_t *Src, size_t SrcOffset, size_t Count) {
+    auto SrcLimbs = numLimbs(SrcOffset + Count);
+    auto DestLimbs = numLimbs(DestOffset + Count);
+    for (size_t Copied = 0; Copied < Count; Copied += SMALL_WORD_BITS) {
+        auto Chunk = std::min(Count - Copied, SMALL_WORD_BITS);
+        auto Bits = readBits(Src, SrcLimbs, SrcOffset + Copied, Chunk);
+        auto Index = (DestOffset + Copied) / SMALL_WORD_BITS;
+        auto Shift = (DestOffset + Copied) % SMALL_WORD_BITS;
+        Dest[Index] |= Bits << Shift;
+        if (Shift != 0 && Index + 1 < DestLimbs) {
+            Dest[Index + 1] |= Bits >> (SMALL_WORD_BITS - Shift);
+        }
+    }
+}
+
+/// Whether Val holds the bits of a word that is not small, i.e. it is not a
+/// view, sparse word, or repeat that still has to be materialized
+static inline bool hasVal(FiniteWord *word) {
+    return word->Val.getBitWidth() == word->Size;
+}
+
+/// Write Pattern repeated into the Size bits of the zeroed limbs D
+/// Size need not be a multiple of the pattern size, the last copy is cut short
+static void fillRepetitions(uint64_t *D, size_t Size, FiniteWord *Pattern) {
+    auto Limbs = numLimbs(Size);
+    
+    if (SMALL_WORD_BITS % Pattern->Size == 0) {
+        // the pattern tiles a limb exactly, so every limb is the same
+        uint64_t Tile = 0;
+        for (size_t i = 0; i < SMALL_WORD_BITS; i += Pattern->Size) {
+            Tile |= Pattern->Small << i;
+        }
+        for (size_t i = 0; i < Limbs; i++) {
+            D[i] = Tile;
+        }
+        D[Limbs - 1] &= topLimbMask(Size);
+        return;
+    }
+    
+    // place one copy of the pattern, then keep copying everything filled so far
+    auto Filled = std::min(Pattern->Size, Size);
+    copyBits(D, 0, getLimbs(Pattern), 0, Filled);
+    while (Filled < Size) {
+        auto Count = std::min(Filled, Size - Filled);
+        copyBits(D, Filled, D, 0, Count);
+        Filled += Count;
+    }
+}
+
+/// Fill in Val of a view, sparse word, or repeat
+/// A view becomes an ordinary word, sparse words and repeats keep their
+/// compact form as well
+static void materialize(FiniteWord *word) {
+    if (hasVal(word)) {
+        return;
+    }
+    word->Val = llvm::APInt(static_cast<unsigned int>(word->Size), 0);
+    auto L = const_cast<uint64_t *>(word->Val.getRawData());
+    if (word->Base) {
+        copyBits(L, 0, getLimbs(word->Base), word->Offset, word->Size);
+        word->Base = nullptr;
+        word->Offset = 0;
+        return;
+    }
+    if (word->Pattern) {
+        fillRepetitions(L, word->Size, word->Pattern);
+        return;
+    }
+    assert(word->SetBits && "Word has no bits");
+    for (auto Position : *word->SetBits) {
+        L[Position / SMALL_WORD_BITS] |= (uint64_t)1 << (Position % SMALL_WORD_BITS);
+    }
+}
+
+/// Val of a word that is not small, materializing views
+static inline const llvm::APInt &getVal(FiniteWord *word) {
+    materialize(word);
+    return word->Val;
+}
+
+/// Count bits of word starting at Offset, Count <= 64, without materializing
+static uint64_t readWordBits(FiniteWord *word, size_t Offset, size_t Count) {
+    if (isSmall(word)) {
+        return Offset >= SMALL_WORD_BITS ? 0 : (word->Small >> Offset) & lowMask(Count);
+    }
+    if (hasVal(word)) {
+        return readBits(getLimbs(word), numLimbs(word->Size), Offset, Count);
+    }
+    if (word->Base) {
+        return readWordBits(word->Base, word->Offset + Offset, Count);
+    }
+    if (word->Pattern) {
+        // read across as many copies of the pattern as needed
+        auto Pattern = word->Pattern;
+        uint64_t Bits = 0;
+        for (size_t Read = 0; Read < Count;) {
+            auto Start = (Offset + Read) % Pattern->Size;
+            auto Chunk = std::min(Count - Read, Pattern->Size - Start);
+            Bits |= readWordBits(Pattern, Start, Chunk) << Read;
+            Read += Chunk;
+        }
+        return Bits;
+    }
+    uint64_t Bits = 0;
+    auto &Positions = *word->SetBits;
+    for (auto It = std::lower_bound(Positions.begin(), Positions.end(), Offset);
+         It != Positions.end() && *It < Offset + Count; ++It) {
+        Bits |= (uint64_t)1 << (*It - Offset);
+    }
+    return Bits;
+}
+
+static inline bool preferSparse(size_t Size, size_t Population) {
+    return Size >= SPARSE_MIN_BITS && Population * SPARSE_BITS_PER_SET_BIT < Size;
+}
+
+/// Word with the given sorted set bit positions, sparse if it is sparse enough
+static FiniteWord *createFromSetBits(size_t Size, const std::vector<uint64_t> &Positions) {
+    if (Size <= SMALL_WORD_BITS) {
+        uint64_t Bits = 0;
+        for (auto Position : Positions) {
+            Bits |= (uint64_t)1 << Position;
+        }
+        return FiniteWord_createFromSmall(Size, Bits);
+    }
+    auto word = new FiniteWord(Size, new std::vector<uint64_t>(Positions));
+    if (!preferSparse(Size, Positions.size())) {
+        materialize(word);
+        word->SetBits = nullptr;
+    }
+    return word;
+}
+
+/// Pattern repeated to Size bits, which is a multiple of the pattern size
+static FiniteWord *createRepeat(size_t Size, FiniteWord *Pattern) {
+    if (Pattern->Pattern) {
+        Pattern = Pattern->Pattern;
+    }
+    if (Size == Pattern->Size) {
+        return Pattern;
+    }
+    return new FiniteWord(Size, Pattern);
+}
+
+/// The Size bits of word starting at bit Offset, without copying when they do
+/// not fit in a small word
+static FiniteWord *createView(FiniteWord *word, size_t Offset, size_t Size) {
+    if (word->Base) {
+        Offset += word->Offset;
+        word = word->Base;
+    }
+    if (Size <= SMALL_WORD_BITS) {
+        return FiniteWord_createFromSmall(Size, readWordBits(word, Offset, Size));
+    }
+    if (word->Pattern) {
+        // a slice of a repeat is a repeat of the pattern rotated to the start of the slice
+        auto Pattern = word->Pattern;
+        auto Rotated = FiniteWord_rotateRight(Pattern, Offset % Pattern->Size);
+        if (Size % Pattern->Size == 0) {
+            return createRepeat(Size, Rotated);
+        }
+        auto Slice = new FiniteWord(Size, llvm::APInt(static_cast<unsigned int>(Size), 0));
+        fillRepetitions(getLimbs(Slice), Size, Rotated);
+        return Slice;
+    }
+    if (word->SetBits) {
+        auto &Positions = *word->SetBits;
+        auto Begin = std::lower_bound(Positions.begin(), Positions.end(), Offset);
+        auto End = std::lower_bound(Begin, Positions.end(), Offset + Size);
+        std::vector<uint64_t> Slice;
+        for (auto It = Begin; It != End; ++It) {
+            Slice.push_back(*It - Offset);
+        }
+        return createFromSetBits(Size, Slice);
+    }
+    return new FiniteWord(Size, word, Offset);
+}
+
 // private
 FiniteWord *FiniteWord_createEmpty() {
-    auto w = new FiniteWord(0, llvm::APInt());
-    return w;
+    return FiniteWord_createFromSmall(0, 0);
 }
 
 FiniteWord *FiniteWord_createFromBool(bool Bit) {
     //llvm::outs() << "FiniteWordImpl_createFromAPInt\n";
-    auto w = FiniteWord_createFromVal(1, (uint64_t)Bit);
+    auto w = FiniteWord_createFromSmall(1, (uint64_t)Bit);
 //    GC_register_finalizer(w, finalize, nullptr, nullptr, nullptr);
     return w;
 }
@@ -84,6 +443,10 @@ FiniteWord *FiniteWord_createFromAPInt(size_t Size, llvm::APInt Init) {
     
     assert(Size != 0 && Size == Init.getBitWidth());
     
+    if (Size <= SMALL_WORD_BITS) {
+        return FiniteWord_createFromSmall(Size, Init.getZExtValue());
+    }
+    
     auto w = new FiniteWord(Size, Init);
 //    GC_register_finalizer(w, finalize, nullptr, nullptr, nullptr);
     return w;
@@ -94,61 +457,328 @@ FiniteWord *FiniteWord_createFromBinaryString(size_t Size, const char *str) {
     
     assert(Size != 0 && Size == strlen(str));
     
+    if (Size <= SMALL_WORD_BITS) {
+        uint64_t Bits = 0;
+        for (size_t i = 0; i < Size; i++) {
+            Bits = (Bits << 1) | (uint64_t)(str[i] == '1');
+        }
+        return FiniteWord_createFromSmall(Size, Bits);
+    }
+    
+    size_t Population = 0;
+    for (size_t i = 0; i < Size; i++) {
+        Population += (str[i] == '1');
+    }
+    if (preferSparse(Size, Population)) {
+        std::vector<uint64_t> Positions;
+        Positions.reserve(Population);
+        for (size_t i = Size; i-- > 0;) {
+            if (str[i] == '1') {
+                Positions.push_back(Size - 1 - i);
+            }
+        }
+        return createFromSetBits(Size, Positions);
+    }
+    
     llvm::StringRef text(str);
     auto Val = llvm::APInt(Size, text, 2);
     return FiniteWord_createFromAPInt(Size, Val);
 }
 
+/// Decimal strings are read 19 digits at a time, the most that fit in a limb
+static const uint64_t PARSE_CHUNK = 10000000000000000000ULL;
+static const size_t PARSE_CHUNK_DIGITS = 19;
+
+/// Strings with more digits than this are split in half first
+static const size_t PARSE_SPLIT_DIGITS = 1 << 10;
+
+typedef LimbVector DecimalLimbs;
+
+/// Value of the Count digits at Str, quadratic, for Count of at most a few PARSE_SPLIT_DIGITS
+static DecimalLimbs parseDecimalDigits(const char *Str, size_t Count) {
+    DecimalLimbs Limbs(1, 0);
+    size_t First = Count % PARSE_CHUNK_DIGITS;
+    if (First == 0) {
+        First = PARSE_CHUNK_DIGITS;
+    }
+    for (size_t i = 0; i < Count;) {
+        auto Digits = i == 0 ? First : PARSE_CHUNK_DIGITS;
+        uint64_t Chunk = 0;
+        uint64_t Multiplier = 1;
+        for (size_t j = 0; j < Digits; j++) {
+            Chunk = Chunk * 10 + static_cast<uint64_t>(Str[i + j] - '0');
+            Multiplier *= 10;
+        }
+        // Limbs = Limbs * Multiplier + Chunk
+        Limbs.push_back(0);
+        llvm::APInt::tcMultiplyPart(Limbs.data(), Limbs.data(), Multiplier, Chunk,
+                                    static_cast<unsigned int>(Limbs.size() - 1), static_cast<unsigned int>(Limbs.size()), false);
+        Limbs.resize(std::max<size_t>(1, LimbArithmetic_activeLimbs(Limbs.data(), Limbs.size())));
+        i += Digits;
+    }
+    return Limbs;
+}
+
+/// Value of the Count digits at Str
+/// Powers[i] is 10^(19 * 2^i), and Count <= 19 * 2^(Level + 1), so the high
+/// digits are multiplied by Powers[Level] and the low digits added
+static DecimalLimbs parseDecimal(const char *Str, size_t Count, const std::vector<DecimalLimbs> &Powers, size_t Level) {
+    while (Level > 0 && Count <= (PARSE_CHUNK_DIGITS << Level)) {
+        Level--;
+    }
+    if (Level == 0 || Count <= PARSE_SPLIT_DIGITS) {
+        return parseDecimalDigits(Str, Count);
+    }
+    auto LowDigits = PARSE_CHUNK_DIGITS << Level;
+    auto High = parseDecimal(Str, Count - LowDigits, Powers, Level - 1);
+    auto Low = parseDecimal(Str + Count - LowDigits, LowDigits, Powers, Level - 1);
+    auto &Power = Powers[Level];
+    DecimalLimbs Result(High.size() + Power.size() + 1, 0);
+    LimbMultiply_multiply(Result.data(), Result.size(), High.data(), High.size(), Power.data(), Power.size());
+    LimbArithmetic_addInto(Result.data(), Result.size(), Low.data(), Low.size());
+    Result.resize(std::max<size_t>(1, LimbArithmetic_activeLimbs(Result.data(), Result.size())));
+    return Result;
+}
+
+/// Value of the decimal string, divide-and-conquer so that the cost is that of
+/// a few large multiplications instead of quadratic
+/// The size is the bits needed, as from FiniteWord_getBitsNeeded, which would
+/// itself parse the string the slow way
+static FiniteWord *createFromLongDecimalString(llvm::StringRef text) {
+    // Powers[i] = 10^(19 * 2^i), up to the first with at least half the digits
+    std::vector<DecimalLimbs> Powers;
+    Powers.push_back(DecimalLimbs(1, PARSE_CHUNK));
+    while ((PARSE_CHUNK_DIGITS << Powers.size()) < text.size()) {
+        auto &Last = Powers.back();
+        DecimalLimbs Square(2 * Last.size(), 0);
+        LimbMultiply_multiply(Square.data(), Square.size(), Last.data(), Last.size(), Last.data(), Last.size());
+        Square.resize(LimbArithmetic_activeLimbs(Square.data(), Square.size()));
+        Powers.push_back(Square);
+    }
+    auto Limbs = parseDecimal(text.data(), text.size(), Powers, Powers.size() - 1);
+    auto Size = std::max<size_t>(1, (Limbs.size() - 1) * SMALL_WORD_BITS + Math_bitLength(Limbs.back()));
+    Limbs.resize(numLimbs(Size), 0);
+    return FiniteWord_createFromAPInt(Size, llvm::APInt(static_cast<unsigned int>(Size), llvm::ArrayRef<uint64_t>(Limbs)));
+}
+
 FiniteWord *FiniteWord_createFromDecimalString(size_t Size, const char *str) {
     //llvm::outs() << "creating FiniteWordImpl: " << str << "\n";
     llvm::StringRef text(str);
     
     assert(Size != 0);
     
+    // 19 decimal digits always fit in 64 bits
+    // anything else, such as a sign, is left to APInt
+    if (text.size() <= 19 && std::all_of(text.begin(), text.end(), [](char c) { return isdigit(static_cast<unsigned char>(c)) != 0; })) {
+        uint64_t Val = 0;
+        for (auto c : text) {
+            Val = Val * 10 + (uint64_t)(c - '0');
+        }
+        auto bits = Val == 0 ? 1 : Math_bitLength(Val);
+        return FiniteWord_createFromSmall(bits, Val);
+    }
+    
     // ignore size for now, will have to use size if we care about zero-padding of the string
+    if (text.size() > PARSE_SPLIT_DIGITS) {
+        return createFromLongDecimalString(text);
+    }
     auto bits = FiniteWord_getBitsNeeded(str, 10);
     auto Val = llvm::APInt(bits, text, 10);
     return FiniteWord_createFromAPInt(bits, Val);
 }
 
 FiniteWord *FiniteWord_createFromVal(size_t numBits, uint64_t val) {
+    if (numBits <= SMALL_WORD_BITS) {
+        return FiniteWord_createFromSmall(numBits, val);
+    }
     auto Val = llvm::APInt(numBits, val, false);
     return FiniteWord_createFromAPInt(numBits, Val);
 }
 
+FiniteWord *FiniteWord_createFromLimbs(size_t numBits, const uint64_t *Limbs) {
+    if (numBits <= SMALL_WORD_BITS) {
+        return FiniteWord_createFromSmall(numBits, numBits == 0 ? 0 : Limbs[0]);
+    }
+    auto Count = numLimbs(numBits);
+    auto Top = Limbs[Count - 1] & topLimbMask(numBits);
+    auto Population = BitKernels_countPopulation(Limbs, Count - 1) + llvm::countPopulation(Top);
+    if (preferSparse(numBits, Population)) {
+        std::vector<uint64_t> Positions;
+        Positions.reserve(Population);
+        for (size_t i = 0; i < Count; i++) {
+            for (auto Bits = i == Count - 1 ? Top : Limbs[i]; Bits != 0; Bits &= Bits - 1) {
+                Positions.push_back(i * SMALL_WORD_BITS + llvm::countTrailingZeros(Bits));
+            }
+        }
+        return createFromSetBits(numBits, Positions);
+    }
+    auto Val = llvm::APInt(static_cast<unsigned int>(numBits), llvm::ArrayRef<uint64_t>(Limbs, numLimbs(numBits)));
+    return FiniteWord_createFromAPInt(numBits, Val);
+}
+
 FiniteWord *FiniteWord_createFromFiniteWord(FiniteWord *src) {
-    if (src->Size == 0) {
-        return FiniteWord_createEmpty();
+    if (isSmall(src)) {
+        return FiniteWord_createFromSmall(src->Size, src->Small);
+    }
+    if (src->SetBits) {
+        // the positions are never modified, so they can be shared
+        return new FiniteWord(src->Size, src->SetBits);
+    }
+    if (src->Pattern) {
+        return new FiniteWord(src->Size, src->Pattern);
+    }
+    return FiniteWord_createFromAPInt(src->Size, getVal(src));
+}
+
+FiniteWord *FiniteWord_createAccumulator(FiniteWord *Init, size_t width) {
+    assert(width >= Init->Size && "Invalid accumulator width");
+    // never interned, so it is safe to modify in place
+    if (width <= SMALL_WORD_BITS) {
+        return new FiniteWord(width, Init->Small);
     }
-    return FiniteWord_createFromAPInt(src->Size, src->Val);
+    return new FiniteWord(width, FiniteWord_toAPInt(Init).zextOrSelf(static_cast<unsigned int>(width)));
 }
 
 // void FiniteWord_release(FiniteWordImpl *word) {
 //     delete word;
 // }
 
-int32_t FiniteWord_newString(FiniteWord *word, char **str) {
+/// Binary digits of each nibble, most significant first
+static const char NibbleDigits[16][4] = {
+    {'0','0','0','0'}, {'0','0','0','1'}, {'0','0','1','0'}, {'0','0','1','1'},
+    {'0','1','0','0'}, {'0','1','0','1'}, {'0','1','1','0'}, {'0','1','1','1'},
+    {'1','0','0','0'}, {'1','0','0','1'}, {'1','0','1','0'}, {'1','0','1','1'},
+    {'1','1','0','0'}, {'1','1','0','1'}, {'1','1','1','0'}, {'1','1','1','1'},
+};
+
+/// Write the Size binary digits of word to Out, most significant first
+static void writeBits(FiniteWord *word, char *Out) {
+    auto Size = word->Size;
+    auto L = getLimbs(word);
     
-    std::string resStr = std::string("`");
+    // the bits above the last whole nibble
+    auto Partial = Size % 4;
+    for (size_t i = 0; i < Partial; i++) {
+        auto index = Size - 1 - i;
+        *Out++ = ((L[index / SMALL_WORD_BITS] >> (index % SMALL_WORD_BITS)) & 1) ? '1' : '0';
+    }
     
-    auto valStr = FiniteWord_bits(word);
-    resStr = resStr + valStr;
+    // nibbles never straddle limbs
+    for (auto index = Size - Partial; index > 0; index -= 4) {
+        auto Nibble = (L[(index - 4) / SMALL_WORD_BITS] >> ((index - 4) % SMALL_WORD_BITS)) & 0xf;
+        memcpy(Out, NibbleDigits[Nibble], 4);
+        Out += 4;
+    }
+}
+
+int32_t FiniteWord_newString(FiniteWord *word, char **str) {
     
-    resStr = resStr + "`";
+    auto resStr = static_cast<char *>(malloc(word->Size + 3));
     
-    *str = strdup(resStr.c_str());
+    resStr[0] = '`';
+    writeBits(word, resStr + 1);
+    resStr[word->Size + 1] = '`';
+    resStr[word->Size + 2] = '\0';
+    
+    *str = resStr;
     
     return 0;
 }
 
+/// Decimal digits are produced 9 at a time, by dividing 32-bit halves of limbs
+static const uint64_t DECIMAL_CHUNK = 1000000000;
+static const size_t DECIMAL_CHUNK_DIGITS = 9;
+
+/// Words with more active bits than this are split by powers of 10 first
+static const size_t DECIMAL_SPLIT_BITS = 2048;
+
+/// Append the decimal digits of Val to Out, padded with 0s to Digits
+/// Quadratic, for Val of at most a few DECIMAL_SPLIT_BITS
+static void appendDecimalDigits(const llvm::APInt &Val, size_t Digits, std::string &Out) {
+    std::vector<uint64_t> Limbs(Val.getRawData(), Val.getRawData() + Val.getNumWords());
+    auto Top = Limbs.size();
+    std::string Reversed;
+    while (true) {
+        while (Top > 0 && Limbs[Top - 1] == 0) {
+            Top--;
+        }
+        if (Top == 0) {
+            break;
+        }
+        uint64_t Rem = 0;
+        for (auto i = Top; i-- > 0;) {
+            auto Hi = (Rem << 32) | (Limbs[i] >> 32);
+            Rem = Hi % DECIMAL_CHUNK;
+            auto Lo = (Rem << 32) | (Limbs[i] & 0xffffffff);
+            Rem = Lo % DECIMAL_CHUNK;
+            Limbs[i] = ((Hi / DECIMAL_CHUNK) << 32) | (Lo / DECIMAL_CHUNK);
+        }
+        for (size_t i = 0; i < DECIMAL_CHUNK_DIGITS; i++) {
+            Reversed.push_back(static_cast<char>('0' + Rem % 10));
+            Rem /= 10;
+        }
+    }
+    while (!Reversed.empty() && Reversed.back() == '0') {
+        Reversed.pop_back();
+    }
+    if (Reversed.size() < Digits) {
+        Reversed.append(Digits - Reversed.size(), '0');
+    }
+    if (Reversed.empty()) {
+        Reversed.push_back('0');
+    }
+    Out.append(Reversed.rbegin(), Reversed.rend());
+}
+
+/// Split Val by Powers[Level] and append the quotient, then the remainder,
+/// each recursively down to appendDecimalDigits, padded with 0s to Digits
+/// Powers[i] is 10^(9 * 2^i) and Val < Powers[Level + 1], so the quotient and
+/// remainder are each half the digits
+static void appendDecimal(const llvm::APInt &Val, size_t Digits, const std::vector<llvm::APInt> &Powers, size_t Level, std::string &Out) {
+    while (Level > 0 && Val.ult(Powers[Level])) {
+        Level--;
+    }
+    if (Level == 0 || Val.getActiveBits() <= DECIMAL_SPLIT_BITS) {
+        appendDecimalDigits(Val, Digits, Out);
+        return;
+    }
+    llvm::APInt Quotient, Remainder;
+    llvm::APInt::udivrem(Val, Powers[Level], Quotient, Remainder);
+    auto LowDigits = DECIMAL_CHUNK_DIGITS << Level;
+    appendDecimal(Quotient, Digits > LowDigits ? Digits - LowDigits : 0, Powers, Level - 1, Out);
+    appendDecimal(Remainder, LowDigits, Powers, Level - 1, Out);
+}
+
+/// Unsigned decimal digits of Val, divide-and-conquer for wide values
+static std::string decimalString(const llvm::APInt &Val) {
+    std::string Out;
+    if (Val.getActiveBits() <= DECIMAL_SPLIT_BITS) {
+        appendDecimalDigits(Val, 0, Out);
+        return Out;
+    }
+    // Powers[i] = 10^(9 * 2^i), up to the first that squared is larger than Val
+    std::vector<llvm::APInt> Powers;
+    Powers.push_back(llvm::APInt(Val.getBitWidth(), DECIMAL_CHUNK));
+    while (true) {
+        bool Overflow;
+        auto Square = Powers.back().umul_ov(Powers.back(), Overflow);
+        if (Overflow || Square.ugt(Val)) {
+            break;
+        }
+        Powers.push_back(Square);
+    }
+    appendDecimal(Val, 0, Powers, Powers.size() - 1, Out);
+    return Out;
+}
+
 int32_t FiniteWord_newDecimalString(FiniteWord *word, char **str) {
     
     std::string resStr = std::string("");
     
-    if (word->Size == 0) {
-        resStr = "0";
+    if (isSmall(word)) {
+        resStr = std::to_string(word->Small);
     } else {
-        resStr = word->Val.toString(10, false).c_str();
+        resStr = decimalString(getVal(word));
     }
     
     *str = strdup(resStr.c_str());
@@ -163,8 +793,18 @@ int32_t FiniteWord_newSignedDecimalString(FiniteWord *word, char **str) {
     if (word->Size == 0) {
         resStr = resStr + "0";
     }
+    else if (isSmall(word)) {
+        // sign-extend from the top bit of the word
+        auto Shift = SMALL_WORD_BITS - word->Size;
+        auto Signed = static_cast<int64_t>(word->Small << Shift) >> Shift;
+        resStr = std::to_string(Signed);
+    }
     else {
-        resStr = word->Val.toString(10, true).c_str();
+        if (getVal(word).isNegative()) {
+            resStr = "-" + decimalString(llvm::APInt(static_cast<unsigned int>(word->Size), 0) - getVal(word));
+        } else {
+            resStr = decimalString(getVal(word));
+        }
     }
     
     *str = strdup(resStr.c_str());
@@ -180,17 +820,9 @@ size_t FiniteWord_size(FiniteWord *word) {
 
 
 const std::string FiniteWord_bits(FiniteWord *word) {
-    std::stringstream ss;
-    for (decltype(word->Size) i = 0; i < word->Size; i++) {
-        auto index = word->Size - 1 - i;
-        auto bit = FiniteWord_getBit(word, static_cast<unsigned int>(index));
-        if (bit == 1) {
-            ss << '1';
-        } else {
-            ss << '0';
-        }
-    }
-    return ss.str();
+    std::string Bits(word->Size, '0');
+    writeBits(word, &Bits[0]);
+    return Bits;
 }
 
 //void FiniteWord_releaseString(char *str) {
@@ -204,23 +836,146 @@ const std::string FiniteWord_bits(FiniteWord *word) {
 
 
 bool FiniteWord_equal(FiniteWord *A, FiniteWord *B) {
-    return A->Val == B->Val;
+    if (isSmall(A) && isSmall(B)) {
+        return A->Small == B->Small;
+    }
+    if (A->SetBits && B->SetBits) {
+        return *A->SetBits == *B->SetBits;
+    }
+    if (A->Pattern && B->Pattern && A->Pattern->Size == B->Pattern->Size) {
+        return FiniteWord_equal(A->Pattern, B->Pattern);
+    }
+    if (A->SetBits || B->SetBits) {
+        // the dense word must have exactly the set bits of the sparse word
+        auto Sparse = A->SetBits ? A : B;
+        auto Dense = A->SetBits ? B : A;
+        if (FiniteWord_countPopulation(Dense) != Sparse->SetBits->size()) {
+            return false;
+        }
+        for (auto Position : *Sparse->SetBits) {
+            if (readWordBits(Dense, Position, 1) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return getVal(A) == getVal(B);
 }
 
 bool FiniteWord_notEqual(FiniteWord *A, FiniteWord *B) {
-    return A->Val != B->Val;
+    return !FiniteWord_equal(A, B);
+}
+
+/// Sums the mixed index and bits of each nonzero limb, so that sparse words
+/// can be hashed from their positions
+uint64_t FiniteWord_hash(FiniteWord *word) {
+    if (word->Hash != 0) {
+        return word->Hash;
+    }
+    uint64_t Hash = Math_mixHash(word->Size);
+    if (word->SetBits) {
+        size_t Index = 0;
+        uint64_t Bits = 0;
+        for (auto Position : *word->SetBits) {
+            if (Position / SMALL_WORD_BITS != Index) {
+                if (Bits != 0) {
+                    Hash += Math_mixHash(Bits ^ Math_mixHash(Index));
+                }
+                Index = Position / SMALL_WORD_BITS;
+                Bits = 0;
+            }
+            Bits |= UINT64_C(1) << (Position % SMALL_WORD_BITS);
+        }
+        if (Bits != 0) {
+            Hash += Math_mixHash(Bits ^ Math_mixHash(Index));
+        }
+    } else {
+        auto Limbs = numLimbs(word->Size);
+        for (size_t i = 0; i < Limbs; i++) {
+            auto Bits = readWordBits(word, i * SMALL_WORD_BITS, std::min(SMALL_WORD_BITS, word->Size - i * SMALL_WORD_BITS));
+            if (Bits != 0) {
+                Hash += Math_mixHash(Bits ^ Math_mixHash(i));
+            }
+        }
+    }
+    // 0 means not yet computed
+    if (Hash == 0) {
+        Hash = 1;
+    }
+    word->Hash = Hash;
+    return Hash;
 }
 
 size_t FiniteWord_getBitWidth(FiniteWord *word) {
-    return word->Val.getBitWidth();
+    return word->Size;
+}
+
+size_t FiniteWord_getActiveBits(FiniteWord *word) {
+    if (isSmall(word)) {
+        return Math_bitLength(word->Small);
+    }
+    auto L = getLimbs(word);
+    auto Active = LimbArithmetic_activeLimbs(L, numLimbs(word->Size));
+    if (Active == 0) {
+        return 0;
+    }
+    return Active * SMALL_WORD_BITS - llvm::countLeadingZeros(L[Active - 1]);
+}
+
+//
+// FixedWord kernels for the common wide widths, see FIXEDWORD_DISPATCH
+//
+
+template <size_t N>
+static FiniteWord *createFixed() {
+    return new FiniteWord(N, llvm::APInt(static_cast<unsigned int>(N), 0));
+}
+
+template <size_t N>
+static FiniteWord *fixedAdd(FiniteWord *A, FiniteWord *B) {
+    auto Res = createFixed<N>();
+    FixedWord<N>::add(getLimbs(Res), getLimbs(A), getLimbs(B));
+    return Res;
+}
+
+template <size_t N>
+static FiniteWord *fixedSubtract(FiniteWord *A, FiniteWord *B) {
+    auto Res = createFixed<N>();
+    FixedWord<N>::subtract(getLimbs(Res), getLimbs(A), getLimbs(B));
+    return Res;
+}
+
+template <size_t N>
+static FiniteWord *fixedMinus(FiniteWord *A) {
+    auto Res = createFixed<N>();
+    FixedWord<N>::negate(getLimbs(Res), getLimbs(A));
+    return Res;
+}
+
+template <size_t N>
+static FiniteWord *fixedMultiply(FiniteWord *A, FiniteWord *B) {
+    auto Res = createFixed<N>();
+    FixedWord<N>::multiply(getLimbs(Res), getLimbs(A), getLimbs(B));
+    return Res;
+}
+
+template <size_t N>
+static FiniteWord *fixedLeftShift(FiniteWord *A, size_t Amount) {
+    auto Res = createFixed<N>();
+    FixedWord<N>::shiftLeft(getLimbs(Res), getLimbs(A), Amount);
+    return Res;
 }
 
-void FiniteWord_setAllBits(FiniteWord *word) {
-    word->Val.setAllBits();
+template <size_t N>
+static FiniteWord *fixedLshr(FiniteWord *A, size_t Amount) {
+    auto Res = createFixed<N>();
+    FixedWord<N>::shiftRight(getLimbs(Res), getLimbs(A), Amount);
+    return Res;
 }
 
-void FiniteWord_clearAllBits(FiniteWord *word) {
-    word->Val.clearAllBits();
+template <size_t N>
+static bool fixedUgt(FiniteWord *A, FiniteWord *B) {
+    return FixedWord<N>::compare(getLimbs(A), getLimbs(B)) > 0;
 }
 
 //FiniteWordImpl& FiniteWordImpl_operator<<=(unsigned ShiftAmt) {
@@ -228,7 +983,12 @@ void FiniteWord_clearAllBits(FiniteWord *word) {
 //    return *this;
 //}
 FiniteWord *FiniteWord_leftShift(FiniteWord *word, size_t ShiftAmount) {
-    auto Shifted = word->Val << ShiftAmount;
+    if (isSmall(word)) {
+        auto Shifted = ShiftAmount >= SMALL_WORD_BITS ? 0 : word->Small << ShiftAmount;
+        return FiniteWord_createFromSmall(word->Size, Shifted);
+    }
+    FIXEDWORD_DISPATCH(word->Size, fixedLeftShift, word, ShiftAmount)
+    auto Shifted = getVal(word) << ShiftAmount;
     return FiniteWord_createFromAPInt(word->Size, Shifted);
 }
 
@@ -242,7 +1002,48 @@ FiniteWord *FiniteWord_leftShift(FiniteWord *word, size_t ShiftAmount) {
 //    return Val[bitPosition];
 //}
 uint8_t FiniteWord_getBit(FiniteWord *word, size_t bitPosition) {
-    return word->Val[bitPosition];
+    if (isSmall(word)) {
+        assert(bitPosition < word->Size && "Bit position out of bounds!");
+        return (word->Small >> bitPosition) & 1;
+    }
+    assert(bitPosition < word->Size && "Bit position out of bounds!");
+    return static_cast<uint8_t>(readWordBits(word, bitPosition, 1));
+}
+
+/// Count bits of period ending just below End and continuing down from the
+/// top of period when the bottom is passed, Count <= 64
+static uint64_t readCyclicBitsDown(FiniteWord *period, size_t End, size_t Count) {
+    uint64_t Bits = 0;
+    for (size_t Read = 0; Read < Count;) {
+        auto Chunk = std::min(Count - Read, End);
+        auto Piece = readWordBits(period, End - Chunk, Chunk);
+        Bits = Chunk == SMALL_WORD_BITS ? Piece : (Bits << Chunk) | Piece;
+        Read += Chunk;
+        End -= Chunk;
+        if (End == 0) {
+            End = period->Size;
+        }
+    }
+    return Bits;
+}
+
+size_t FiniteWord_commonTopRun(FiniteWord *period, FiniteWord *transient) {
+    auto PeriodSize = period->Size;
+    auto TransientSize = transient->Size;
+    assert(PeriodSize > 0 && "Period size is 0");
+    for (size_t Matched = 0; Matched < TransientSize;) {
+        auto Count = std::min(SMALL_WORD_BITS, TransientSize - Matched);
+        auto TransientBits = readWordBits(transient, TransientSize - Matched - Count, Count);
+        auto PeriodBits = readCyclicBitsDown(period, PeriodSize - Matched % PeriodSize, Count);
+        auto Diff = TransientBits ^ PeriodBits;
+        if (Diff != 0) {
+            // bits above the highest difference match
+            auto Highest = SMALL_WORD_BITS - 1 - llvm::countLeadingZeros(Diff);
+            return Matched + Count - 1 - Highest;
+        }
+        Matched += Count;
+    }
+    return TransientSize;
 }
 
 //char *toString(FiniteWordImpl *word, uint8_t Radix, bool Signed) {
@@ -257,19 +1058,183 @@ uint8_t FiniteWord_getBit(FiniteWord *word, size_t bitPosition) {
 //    return Val != RHS.Val;
 //}
 
+/// Rotate the low Size bits of Bits left by Amount
+static inline uint64_t rotateLeftSmall(uint64_t Bits, size_t Size, size_t Amount) {
+    if (Size == 0) {
+        return 0;
+    }
+    Amount %= Size;
+    if (Amount == 0) {
+        return Bits;
+    }
+    return ((Bits << Amount) | (Bits >> (Size - Amount))) & lowMask(Size);
+}
+
 FiniteWord *FiniteWord_rotateRight(FiniteWord *word, size_t rotateAmt) {
-    auto Rotated = word->Val.rotr(rotateAmt);
-    return FiniteWord_createFromAPInt(word->Size, Rotated);
+    if (isSmall(word)) {
+        if (word->Size == 0) {
+            return word;
+        }
+        auto Rotated = rotateLeftSmall(word->Small, word->Size, word->Size - rotateAmt % word->Size);
+        return FiniteWord_createFromSmall(word->Size, Rotated);
+    }
+    return FiniteWord_rotateLeft(word, word->Size - rotateAmt % word->Size);
 }
 
+/// Each bit goes up by rotateAmt, wrapping around
+/// The two pieces are copied straight into the output, with no shifted temporaries
 FiniteWord *FiniteWord_rotateLeft(FiniteWord *word, size_t rotateAmt) {
-    auto Rotated = word->Val.rotl(rotateAmt);
-    return FiniteWord_createFromAPInt(word->Size, Rotated);
+    if (isSmall(word)) {
+        auto Rotated = rotateLeftSmall(word->Small, word->Size, rotateAmt);
+        return FiniteWord_createFromSmall(word->Size, Rotated);
+    }
+    auto Size = word->Size;
+    auto Amount = rotateAmt % Size;
+    if (Amount == 0) {
+        return word;
+    }
+    auto Cut = Size - Amount;
+    if (word->Pattern) {
+        // rotating every copy of the pattern together
+        auto Pattern = word->Pattern;
+        return createRepeat(Size, FiniteWord_rotateLeft(Pattern, Amount % Pattern->Size));
+    }
+    if (word->SetBits) {
+        // the positions from Cut up wrap around to the bottom, and stay sorted
+        auto &SetBits = *word->SetBits;
+        auto Split = std::lower_bound(SetBits.begin(), SetBits.end(), Cut);
+        std::vector<uint64_t> Positions;
+        Positions.reserve(SetBits.size());
+        for (auto Iter = Split; Iter != SetBits.end(); ++Iter) {
+            Positions.push_back(*Iter - Cut);
+        }
+        for (auto Iter = SetBits.begin(); Iter != Split; ++Iter) {
+            Positions.push_back(*Iter + Amount);
+        }
+        return createFromSetBits(Size, Positions);
+    }
+    auto Rotated = new FiniteWord(Size, llvm::APInt(static_cast<unsigned int>(Size), 0));
+    auto D = getLimbs(Rotated);
+    auto S = getLimbs(word);
+    copyBits(D, Amount, S, 0, Cut);
+    copyBits(D, 0, S, Cut, Amount);
+    return Rotated;
+}
+
+#define REVERSE2(n) n, n + 2 * 64, n + 1 * 64, n + 3 * 64
+#define REVERSE4(n) REVERSE2(n), REVERSE2(n + 2 * 16), REVERSE2(n + 1 * 16), REVERSE2(n + 3 * 16)
+#define REVERSE6(n) REVERSE4(n), REVERSE4(n + 2 * 4), REVERSE4(n + 1 * 4), REVERSE4(n + 3 * 4)
+
+/// Each byte with its bits in reverse order
+static const uint8_t ReversedBytes[256] = { REVERSE6(0), REVERSE6(2), REVERSE6(1), REVERSE6(3) };
+
+#undef REVERSE2
+#undef REVERSE4
+#undef REVERSE6
+
+/// The bytes swap places with bswap, then the table reverses each byte
+static inline uint64_t reverseLimb(uint64_t X) {
+    X = llvm::sys::getSwappedBytes(X);
+    uint64_t Reversed = 0;
+    for (unsigned i = 0; i < SMALL_WORD_BITS; i += 8) {
+        Reversed |= static_cast<uint64_t>(ReversedBytes[(X >> i) & 0xff]) << i;
+    }
+    return Reversed;
 }
 
 FiniteWord *FiniteWord_reverse(FiniteWord *word) {
-    auto Reversed = word->Val.reverseBits();
-    return FiniteWord_createFromAPInt(word->Size, Reversed);
+    if (isSmall(word)) {
+        if (word->Size == 0) {
+            return word;
+        }
+        auto Reversed = llvm::reverseBits(word->Small) >> (SMALL_WORD_BITS - word->Size);
+        return FiniteWord_createFromSmall(word->Size, Reversed);
+    }
+    auto Size = word->Size;
+    if (word->Pattern) {
+        return createRepeat(Size, FiniteWord_reverse(word->Pattern));
+    }
+    if (word->SetBits) {
+        auto &SetBits = *word->SetBits;
+        std::vector<uint64_t> Positions;
+        Positions.reserve(SetBits.size());
+        for (auto Iter = SetBits.rbegin(); Iter != SetBits.rend(); ++Iter) {
+            Positions.push_back(Size - 1 - *Iter);
+        }
+        return createFromSetBits(Size, Positions);
+    }
+
+    // reversing whole limbs reverses 64 * Limbs bits, which leaves the word
+    // Shift bits too high, so shift it down in the same pass
+    auto Reversed = new FiniteWord(Size, llvm::APInt(static_cast<unsigned int>(Size), 0));
+    auto D = getLimbs(Reversed);
+    auto S = getLimbs(word);
+    auto Limbs = numLimbs(Size);
+    auto Shift = Limbs * SMALL_WORD_BITS - Size;
+    for (size_t i = 0; i < Limbs; i++) {
+        auto Bits = reverseLimb(S[Limbs - 1 - i]) >> Shift;
+        if (Shift != 0 && i + 1 < Limbs) {
+            Bits |= reverseLimb(S[Limbs - 2 - i]) << (SMALL_WORD_BITS - Shift);
+        }
+        D[i] = Bits;
+    }
+    return Reversed;
+}
+
+//
+// Sparse kernels, where at least one operand is sparse
+//
+
+static FiniteWord *sparseAnd(FiniteWord *A, FiniteWord *B) {
+    if (!A->SetBits) {
+        std::swap(A, B);
+    }
+    std::vector<uint64_t> Positions;
+    if (B->SetBits) {
+        std::set_intersection(A->SetBits->begin(), A->SetBits->end(), B->SetBits->begin(), B->SetBits->end(), std::back_inserter(Positions));
+    } else {
+        for (auto Position : *A->SetBits) {
+            if (readWordBits(B, Position, 1)) {
+                Positions.push_back(Position);
+            }
+        }
+    }
+    return createFromSetBits(A->Size, Positions);
+}
+
+static FiniteWord *sparseOrXor(FiniteWord *A, FiniteWord *B, bool Xor) {
+    if (!A->SetBits) {
+        std::swap(A, B);
+    }
+    if (B->SetBits) {
+        std::vector<uint64_t> Positions;
+        if (Xor) {
+            std::set_symmetric_difference(A->SetBits->begin(), A->SetBits->end(), B->SetBits->begin(), B->SetBits->end(), std::back_inserter(Positions));
+        } else {
+            std::set_union(A->SetBits->begin(), A->SetBits->end(), B->SetBits->begin(), B->SetBits->end(), std::back_inserter(Positions));
+        }
+        return createFromSetBits(A->Size, Positions);
+    }
+    // dense result, so start from the dense operand
+    auto Result = new FiniteWord(B->Size, getVal(B));
+    auto L = getLimbs(Result);
+    for (auto Position : *A->SetBits) {
+        auto Bit = (uint64_t)1 << (Position % SMALL_WORD_BITS);
+        if (Xor) {
+            L[Position / SMALL_WORD_BITS] ^= Bit;
+        } else {
+            L[Position / SMALL_WORD_BITS] |= Bit;
+        }
+    }
+    return Result;
+}
+
+static FiniteWord *sparseOr(FiniteWord *A, FiniteWord *B) {
+    return sparseOrXor(A, B, false);
+}
+
+static FiniteWord *sparseXor(FiniteWord *A, FiniteWord *B) {
+    return sparseOrXor(A, B, true);
 }
 
 //FiniteWordImpl FiniteWordImpl_operator~() const {
@@ -277,7 +1242,18 @@ FiniteWord *FiniteWord_reverse(FiniteWord *word) {
 //    return FiniteWordImpl(Not);
 //}
 FiniteWord *FiniteWord_not(FiniteWord *word) {
-    return FiniteWord_createFromAPInt(word->Size, ~word->Val);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size, ~word->Small);
+    }
+    if (word->Pattern) {
+        return createRepeat(word->Size, FiniteWord_not(word->Pattern));
+    }
+    auto Not = new FiniteWord(word->Size, llvm::APInt(static_cast<unsigned int>(word->Size), 0));
+    auto Limbs = numLimbs(word->Size);
+    auto D = getLimbs(Not);
+    BitKernels_not(D, getLimbs(word), Limbs);
+    D[Limbs - 1] &= topLimbMask(word->Size);
+    return Not;
 }
 
 //FiniteWordImpl FiniteWordImpl_operator^(const FiniteWordImpl &b) const {
@@ -285,7 +1261,18 @@ FiniteWord *FiniteWord_not(FiniteWord *word) {
 //    return FiniteWordImpl(Xor);
 //}
 FiniteWord *FiniteWord_xor(FiniteWord *word, FiniteWord *RHS) {
-    return FiniteWord_createFromAPInt(word->Size, word->Val ^ RHS->Val);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size, word->Small ^ RHS->Small);
+    }
+    if (word->SetBits || RHS->SetBits) {
+        return sparseXor(word, RHS);
+    }
+    if (word->Pattern && RHS->Pattern && word->Pattern->Size == RHS->Pattern->Size) {
+        return createRepeat(word->Size, FiniteWord_xor(word->Pattern, RHS->Pattern));
+    }
+    auto Result = new FiniteWord(word->Size, llvm::APInt(static_cast<unsigned int>(word->Size), 0));
+    BitKernels_xor(getLimbs(Result), getLimbs(word), getLimbs(RHS), numLimbs(word->Size));
+    return Result;
 }
 
 //
@@ -294,7 +1281,18 @@ FiniteWord *FiniteWord_xor(FiniteWord *word, FiniteWord *RHS) {
 //    return FiniteWordImpl(And);
 //}
 FiniteWord *FiniteWord_and(FiniteWord *word, FiniteWord *RHS) {
-    return FiniteWord_createFromAPInt(word->Size, word->Val & RHS->Val);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size, word->Small & RHS->Small);
+    }
+    if (word->SetBits || RHS->SetBits) {
+        return sparseAnd(word, RHS);
+    }
+    if (word->Pattern && RHS->Pattern && word->Pattern->Size == RHS->Pattern->Size) {
+        return createRepeat(word->Size, FiniteWord_and(word->Pattern, RHS->Pattern));
+    }
+    auto Result = new FiniteWord(word->Size, llvm::APInt(static_cast<unsigned int>(word->Size), 0));
+    BitKernels_and(getLimbs(Result), getLimbs(word), getLimbs(RHS), numLimbs(word->Size));
+    return Result;
 }
 
 
@@ -304,20 +1302,58 @@ FiniteWord *FiniteWord_and(FiniteWord *word, FiniteWord *RHS) {
 //    return FiniteWordImpl(Or);
 //}
 FiniteWord *FiniteWord_or(FiniteWord *word, FiniteWord *RHS) {
-    return FiniteWord_createFromAPInt(word->Size, word->Val | RHS->Val);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size, word->Small | RHS->Small);
+    }
+    if (word->SetBits || RHS->SetBits) {
+        return sparseOr(word, RHS);
+    }
+    if (word->Pattern && RHS->Pattern && word->Pattern->Size == RHS->Pattern->Size) {
+        return createRepeat(word->Size, FiniteWord_or(word->Pattern, RHS->Pattern));
+    }
+    auto Result = new FiniteWord(word->Size, llvm::APInt(static_cast<unsigned int>(word->Size), 0));
+    BitKernels_or(getLimbs(Result), getLimbs(word), getLimbs(RHS), numLimbs(word->Size));
+    return Result;
 }
 
 
 uint64_t FiniteWord_getRawData(FiniteWord *word) {
-    return *word->Val.getRawData();
+    if (isSmall(word)) {
+        return word->Small;
+    }
+    return readWordBits(word, 0, SMALL_WORD_BITS);
+}
+
+void FiniteWord_copyLimbs(FiniteWord *word, uint64_t *Limbs) {
+    if (isSmall(word)) {
+        if (word->Size != 0) {
+            Limbs[0] = word->Small;
+        }
+        return;
+    }
+    if (hasVal(word)) {
+        std::copy_n(getLimbs(word), numLimbs(word->Size), Limbs);
+        return;
+    }
+    for (size_t i = 0; i < numLimbs(word->Size); i++) {
+        auto Offset = i * SMALL_WORD_BITS;
+        Limbs[i] = readWordBits(word, Offset, std::min(SMALL_WORD_BITS, word->Size - Offset));
+    }
 }
 
 bool FiniteWord_ugt(FiniteWord *word, FiniteWord *RHS) {
-    return word->Val.ugt(RHS->Val);
+    if (isSmall(word)) {
+        return word->Small > RHS->Small;
+    }
+    FIXEDWORD_DISPATCH(word->Size, fixedUgt, word, RHS)
+    return getVal(word).ugt(getVal(RHS));
 }
 
 FiniteWord *FiniteWord_trunc(FiniteWord *word, size_t truncAmt) {
-    auto Truncated = word->Val.trunc(truncAmt);
+    if (truncAmt <= SMALL_WORD_BITS) {
+        return FiniteWord_createFromSmall(truncAmt, FiniteWord_getRawData(word));
+    }
+    auto Truncated = getVal(word).trunc(truncAmt);
     return FiniteWord_createFromAPInt(truncAmt, Truncated);
 }
 
@@ -329,21 +1365,43 @@ FiniteWord *FiniteWord_residue(FiniteWord *word, size_t width) {
     if (width == 0) {
         return FiniteWord_EMPTY;
     }
-    return FiniteWord_trunc(word, width);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(width, word->Small);
+    }
+    return createView(word, 0, width);
 }
 
 FiniteWord *FiniteWord_lshr(FiniteWord *word, size_t shiftAmt) {
-    auto Shifted = word->Val.lshr(shiftAmt);
+    if (isSmall(word)) {
+        auto Shifted = shiftAmt >= SMALL_WORD_BITS ? 0 : word->Small >> shiftAmt;
+        return FiniteWord_createFromSmall(word->Size, Shifted);
+    }
+    FIXEDWORD_DISPATCH(word->Size, fixedLshr, word, shiftAmt)
+    auto Shifted = getVal(word).lshr(shiftAmt);
     return FiniteWord_createFromAPInt(word->Size, Shifted);
 }
 
 FiniteWord *FiniteWord_zext(FiniteWord *word, size_t width) {
-    auto Extended = word->Val.zext(width);
+    assert(width >= word->Size && "Invalid zext width");
+    if (width <= SMALL_WORD_BITS) {
+        return FiniteWord_createFromSmall(width, word->Small);
+    }
+    auto Extended = FiniteWord_toAPInt(word).zext(width);
     return FiniteWord_createFromAPInt(width, Extended);
 }
 
 bool FiniteWord_isSplat(FiniteWord *word, size_t SplatSizeInBits) {
-    return word->Val.isSplat(SplatSizeInBits);
+    if (isSmall(word)) {
+        assert(word->Size % SplatSizeInBits == 0 && "Invalid splat size");
+        return rotateLeftSmall(word->Small, word->Size, SplatSizeInBits) == word->Small;
+    }
+    if (word->Pattern) {
+        assert(word->Size % SplatSizeInBits == 0 && "Invalid splat size");
+        // periods SplatSizeInBits and the pattern size give their gcd as a period
+        auto Pattern = word->Pattern;
+        return hasPeriod(Pattern, Math_gcd(SplatSizeInBits, Pattern->Size));
+    }
+    return getVal(word).isSplat(SplatSizeInBits);
 }
 
 //FiniteWordImpl FiniteWordImpl_operator-() const {
@@ -367,41 +1425,100 @@ bool FiniteWord_isSplat(FiniteWord *word, size_t SplatSizeInBits) {
 //}
 
 FiniteWord *FiniteWord_minus(FiniteWord *word) {
-    return FiniteWord_createFromAPInt(word->Size, -word->Val);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size, -word->Small);
+    }
+    FIXEDWORD_DISPATCH(word->Size, fixedMinus, word)
+    return FiniteWord_createFromAPInt(word->Size, -getVal(word));
 }
 
 //    FiniteWordImpl operator-(const FiniteWordImpl &b);
 FiniteWord *FiniteWord_subtract(FiniteWord *word, FiniteWord *RHS) {
-    return FiniteWord_createFromAPInt(word->Size, word->Val - RHS->Val);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size, word->Small - RHS->Small);
+    }
+    FIXEDWORD_DISPATCH(word->Size, fixedSubtract, word, RHS)
+    return FiniteWord_createFromAPInt(word->Size, getVal(word) - getVal(RHS));
 }
 
 //    FiniteWordImpl operator+(const FiniteWordImpl &b);
 FiniteWord *FiniteWord_add(FiniteWord *word, FiniteWord *RHS) {
-    return FiniteWord_createFromAPInt(word->Size, word->Val + RHS->Val);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size, word->Small + RHS->Small);
+    }
+    FIXEDWORD_DISPATCH(word->Size, fixedAdd, word, RHS)
+    return FiniteWord_createFromAPInt(word->Size, getVal(word) + getVal(RHS));
 }
 
 //    FiniteWordImpl operator*(const FiniteWordImpl &b);
 FiniteWord *FiniteWord_multiply(FiniteWord *word, FiniteWord *RHS) {
-    return FiniteWord_createFromAPInt(word->Size, word->Val * RHS->Val);
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size, word->Small * RHS->Small);
+    }
+    FIXEDWORD_DISPATCH(word->Size, fixedMultiply, word, RHS)
+    auto Product = new FiniteWord(word->Size, llvm::APInt(static_cast<unsigned int>(word->Size), 0));
+    auto Limbs = numLimbs(word->Size);
+    auto D = getLimbs(Product);
+    LimbMultiply_multiply(D, Limbs, getLimbs(word), Limbs, getLimbs(RHS), Limbs);
+    D[Limbs - 1] &= topLimbMask(word->Size);
+    return Product;
+}
+
+/// Quotient and remainder of words that are not small, either may be null
+static void divideRemainder(FiniteWord *LHS, FiniteWord *RHS, FiniteWord **Quotient, FiniteWord **Remainder) {
+    auto Size = LHS->Size;
+    auto Limbs = numLimbs(Size);
+    uint64_t *QuotientLimbs = nullptr;
+    uint64_t *RemainderLimbs = nullptr;
+    if (Quotient) {
+        *Quotient = new FiniteWord(Size, llvm::APInt(static_cast<unsigned int>(Size), 0));
+        QuotientLimbs = getLimbs(*Quotient);
+    }
+    if (Remainder) {
+        *Remainder = new FiniteWord(Size, llvm::APInt(static_cast<unsigned int>(Size), 0));
+        RemainderLimbs = getLimbs(*Remainder);
+    }
+    LimbDivide_divideRemainder(QuotientLimbs, Limbs, RemainderLimbs, Limbs, getLimbs(LHS), Limbs, getLimbs(RHS), Limbs);
 }
 
 FiniteWord *FiniteWord_udiv(FiniteWord *word, FiniteWord *RHS) {
-    auto Div = word->Val.udiv(RHS->Val);
-    return FiniteWord_createFromAPInt(word->Size, Div);
+    if (isSmall(word)) {
+        assert(RHS->Small != 0 && "Divide by zero?");
+        return FiniteWord_createFromSmall(word->Size, word->Small / RHS->Small);
+    }
+    FiniteWord *Div;
+    divideRemainder(word, RHS, &Div, nullptr);
+    return Div;
 }
 
 FiniteWord *FiniteWord_urem(FiniteWord *word, FiniteWord *RHS) {
-    auto Rem = word->Val.urem(RHS->Val);
-    return FiniteWord_createFromAPInt(word->Size, Rem);
+    if (isSmall(word)) {
+        assert(RHS->Small != 0 && "Remainder by zero?");
+        return FiniteWord_createFromSmall(word->Size, word->Small % RHS->Small);
+    }
+    FiniteWord *Rem;
+    divideRemainder(word, RHS, nullptr, &Rem);
+    return Rem;
 }
 
 FiniteWord *FiniteWord_zextOrSelf(FiniteWord *word, size_t width) {
-    auto Extended = word->Val.zextOrSelf(width);
-    return FiniteWord_createFromAPInt(width, Extended);
+    if (width == word->Size) {
+        return FiniteWord_createFromFiniteWord(word);
+    }
+    return FiniteWord_zext(word, width);
 }
 
 size_t FiniteWord_countPopulation(FiniteWord *word) {
-    return word->Val.countPopulation();
+    if (isSmall(word)) {
+        return llvm::countPopulation(word->Small);
+    }
+    if (word->SetBits) {
+        return word->SetBits->size();
+    }
+    if (word->Pattern) {
+        return FiniteWord_countPopulation(word->Pattern) * (word->Size / word->Pattern->Size);
+    }
+    return BitKernels_countPopulation(getLimbs(word), numLimbs(word->Size));
 }
 
 
@@ -429,11 +1546,13 @@ unsigned FiniteWord_getBitsNeeded(const char * str, uint8_t radix) {
 
 void FiniteWord_udivrem(FiniteWord *LHS, FiniteWord *RHS, FiniteWord **Quotient, FiniteWord **Remainder) {
     auto Size = FiniteWord_size(LHS);
-    llvm::APInt TmpRemainder;
-    llvm::APInt TmpQuotient;
-    llvm::APInt::udivrem(LHS->Val, RHS->Val, TmpQuotient, TmpRemainder);
-    *Remainder = FiniteWord_createFromAPInt(Size, TmpRemainder);
-    *Quotient = FiniteWord_createFromAPInt(Size, TmpQuotient);
+    if (isSmall(LHS)) {
+        assert(RHS->Small != 0 && "Divide by zero?");
+        *Remainder = FiniteWord_createFromSmall(Size, LHS->Small % RHS->Small);
+        *Quotient = FiniteWord_createFromSmall(Size, LHS->Small / RHS->Small);
+        return;
+    }
+    divideRemainder(LHS, RHS, Quotient, Remainder);
 }
 
 
@@ -489,48 +1608,21 @@ FiniteWord *FiniteWord_createFromRepsWord(size_t Repetitions, FiniteWord *Patter
         return FiniteWord_EMPTY;
     }
 
-    // optimizations for all 0s and all 1s
-    {
-        auto pop = FiniteWord_countPopulation(Pattern);
-        if (pop == 0) {
-            // all 0s
-            auto Accumulate = FiniteWord_createFromVal(static_cast<unsigned int>(size), (uint64_t)0);
-            FiniteWord_clearAllBits(Accumulate);
-            return Accumulate;
-        }
-        if (pop == Pattern->Size) {
-            // all 1s
-            auto Accumulate = FiniteWord_createFromVal(static_cast<unsigned int>(size), (uint64_t)0);
-            FiniteWord_setAllBits(Accumulate);
-            return Accumulate;
-        }
-    }
-
-    auto Width = Math_bitLength(Repetitions);
-    auto FiniteWordReps = llvm::APInt(static_cast<unsigned int>(Width), Repetitions, false);
-    auto ReversedReps = FiniteWordReps.reverseBits();
-    assert(ReversedReps[0] == 1 && "ReversedReps[0] must be 1");
-    ReversedReps = ReversedReps.lshr(1);
-    auto PatternExtended = FiniteWord_zextOrSelf(Pattern, static_cast<unsigned int>(size));
-    auto Accumulate = PatternExtended;
-    auto AccumulatedSize = Pattern->Size;
-    while (AccumulatedSize < size) {
-        // double the reps
-        auto Original = Accumulate;
-        Accumulate = FiniteWord_leftShift(Accumulate, static_cast<unsigned int>(AccumulatedSize));
-        Accumulate = FiniteWord_or(Accumulate, Original);
-        AccumulatedSize *= 2;
-        if (ReversedReps[0] == 1) {
-            // add 1 rep
-            Accumulate = FiniteWord_leftShift(Accumulate, static_cast<unsigned int>(Pattern->Size));
-            Accumulate = FiniteWord_or(Accumulate, PatternExtended);
-            AccumulatedSize += Pattern->Size;
-        }
-        ReversedReps = ReversedReps.lshr(1);
-    }
-    assert(AccumulatedSize == size && "Accumulated size is not expected size");
-    assert(ReversedReps.getActiveBits() == 0 && "ReversedReps is not properly processed");
-    return Accumulate;
+    // words are immutable, and shifting by a whole 64-bit pattern is undefined
+    if (Repetitions == 1) {
+        return Pattern;
+    }
+
+    if (size <= SMALL_WORD_BITS) {
+        uint64_t Bits = 0;
+        for (size_t i = 0; i < Repetitions; i++) {
+            Bits = (Bits << Pattern->Size) | Pattern->Small;
+        }
+        return FiniteWord_createFromSmall(size, Bits);
+    }
+
+    // expanded only when an operation needs the limbs
+    return createRepeat(size, Pattern);
 }
 
 //const FiniteWord FiniteWord::FactoryBool(bool Bit) {
@@ -696,18 +1788,21 @@ bool FiniteWord_arrayEqual(FiniteWord **ToTest, size_t Count) {
 
 bool FiniteWord_arrayNotEqual(FiniteWord **ToTest, size_t Count) {
    assert(Count > 1 && "Vals does not contain more than one element");
-   std::vector<FiniteWord *> Vals(ToTest, ToTest + Count);
-   for (auto Iter = Vals.begin(); Iter != Vals.end(); ++Iter) {
-       auto First = *Iter;
-       auto Iter2 = Iter;
-       Iter2++;
-       for (; Iter2 != Vals.end(); Iter2++) {
-           auto Second = *Iter2;
+   // only words with the same hash are compared in full
+   std::unordered_multimap<uint64_t, FiniteWord *> Seen;
+   Seen.reserve(Count);
+   for (size_t i = 0; i < Count; i++) {
+       auto Second = ToTest[i];
+       auto Hash = FiniteWord_hash(Second);
+       auto Range = Seen.equal_range(Hash);
+       for (auto Iter = Range.first; Iter != Range.second; ++Iter) {
+           auto First = Iter->second;
            // maintain intuitive order
-           if (FiniteWord_equal(Second, First)) {
+           if (Second->Size == First->Size && FiniteWord_equal(Second, First)) {
                return false;
            }
        }
+       Seen.insert(std::make_pair(Hash, Second));
    }
    return true;
 }
@@ -725,18 +1820,19 @@ FiniteWord *FiniteWord_shiftRight(FiniteWord *word, size_t i) {
     if (i == word->Size) {
         return FiniteWord_EMPTY;
     }
-    auto Shifted = FiniteWord_lshr(word, i);
-    Shifted = FiniteWord_trunc(Shifted, word->Size - i);
-    return Shifted;
+    if (isSmall(word)) {
+        return FiniteWord_createFromSmall(word->Size - i, word->Small >> i);
+    }
+    return createView(word, i, word->Size - i);
 }
 
-// this could be passed in as Hi or Lo, so make sure to make
-// a copy first
+// word could be passed in as Hi or Lo, so take both slices before assigning
 void FiniteWord_shiftRightResidue(FiniteWord *word, size_t i, FiniteWord **Hi, FiniteWord **Lo) {
     assert(i <= word->Size && "Index too large");
-    auto Tmp = *word;
-    *Hi = FiniteWord_shiftRight(&Tmp, i);
-    *Lo = FiniteWord_residue(&Tmp, i);
+    auto HiWord = FiniteWord_shiftRight(word, i);
+    auto LoWord = FiniteWord_residue(word, i);
+    *Hi = HiWord;
+    *Lo = LoWord;
 }
 
 FiniteWord *FiniteWord_concatenate(FiniteWord *word, FiniteWord *other) {
@@ -746,51 +1842,139 @@ FiniteWord *FiniteWord_concatenate(FiniteWord *word, FiniteWord *other) {
    if (FiniteWord_size(other) == 0) {
        return word;
    }
-   auto Res = FiniteWord_zextOrSelf(word, FiniteWord_size(word) + FiniteWord_size(other));
-   auto B = FiniteWord_zextOrSelf(other, FiniteWord_size(word) + FiniteWord_size(other));
-   Res = FiniteWord_leftShift(Res, FiniteWord_size(other));
-   Res = FiniteWord_or(Res, B);
-   return Res;
+   if (FiniteWord_size(word) + FiniteWord_size(other) <= SMALL_WORD_BITS) {
+       return FiniteWord_createFromSmall(FiniteWord_size(word) + FiniteWord_size(other), (word->Small << other->Size) | other->Small);
+   }
+   auto Builder = FiniteWordBuilder_create();
+   FiniteWordBuilder_append(Builder, other);
+   FiniteWordBuilder_append(Builder, word);
+   return FiniteWordBuilder_finish(Builder);
+}
+
+struct FiniteWordBuilder {
+    std::vector<FiniteWord *> Pieces;
+    size_t Size;
+    
+    FiniteWordBuilder() :
+        Size(0) {}
+};
+
+FiniteWordBuilder *FiniteWordBuilder_create() {
+    return new FiniteWordBuilder();
+}
+
+void FiniteWordBuilder_append(FiniteWordBuilder *builder, FiniteWord *bits) {
+    if (bits->Size == 0) {
+        return;
+    }
+    builder->Pieces.push_back(bits);
+    builder->Size += bits->Size;
+}
+
+FiniteWord *FiniteWordBuilder_finish(FiniteWordBuilder *builder) {
+    auto Size = builder->Size;
+    FiniteWord *Res;
+    if (Size == 0) {
+        Res = FiniteWord_EMPTY;
+    } else if (builder->Pieces.size() == 1) {
+        Res = builder->Pieces[0];
+    } else if (Size <= SMALL_WORD_BITS) {
+        uint64_t Bits = 0;
+        size_t Offset = 0;
+        for (auto Piece : builder->Pieces) {
+            Bits |= Piece->Small << Offset;
+            Offset += Piece->Size;
+        }
+        Res = FiniteWord_createFromSmall(Size, Bits);
+    } else {
+        Res = new FiniteWord(Size, llvm::APInt(static_cast<unsigned int>(Size), 0));
+        auto D = getLimbs(Res);
+        size_t Offset = 0;
+        for (auto Piece : builder->Pieces) {
+            auto Src = isSmall(Piece) ? &Piece->Small : getLimbs(Piece);
+            copyBits(D, Offset, Src, 0, Piece->Size);
+            Offset += Piece->Size;
+        }
+    }
+    delete builder;
+    return Res;
 }
 
-/// copied from ScalarEvolution.cpp
 FiniteWord *FiniteWord_gcd(FiniteWord *A, FiniteWord *B) {
+    if (isSmall(A)) {
+        return FiniteWord_createFromSmall(A->Size, Math_gcd(A->Small, B->Small));
+    }
     
-    auto GCD = llvm::APIntOps::GreatestCommonDivisor(A->Val, B->Val);
-    return FiniteWord_createFromAPInt(A->Size, GCD);
+    auto GCD = new FiniteWord(A->Size, llvm::APInt(static_cast<unsigned int>(A->Size), 0));
+    auto Limbs = numLimbs(A->Size);
+    LimbGcd_gcd(getLimbs(GCD), Limbs, getLimbs(A), Limbs, getLimbs(B), Limbs);
+    return GCD;
 }
 
-void FiniteWord_compressPeriod(FiniteWord **period) {
-    auto periodSize = (*period)->Size;
-    auto sq = (size_t)sqrt(periodSize);
-    for (decltype(sq) testDivisor = 1; testDivisor <= sq; testDivisor++) {
-        if (periodSize % testDivisor == 0) {
-
-            // first use testDivisor
-            if (periodSize > 1) {
-                if (FiniteWord_isSplat(*period, testDivisor)) {
-                    auto modWord = FiniteWord_residue(*period, testDivisor);
-                    *period = modWord;
-
-                    // recurse on compressedPeriod, but it is now smaller
-                    FiniteWord_compressPeriod(period);
-                    return;
-                }
-            }
+void FiniteWord_allocatorStats(uint64_t *Allocations, uint64_t *Reuses, uint64_t *BytesMapped, uint64_t *BytesInUse, uint64_t *BytesCached) {
+    auto Stats = LimbAllocator_stats();
+    *Allocations = Stats.Allocations;
+    *Reuses = Stats.Reuses;
+    *BytesMapped = Stats.BytesMapped;
+    *BytesInUse = Stats.BytesInUse;
+    *BytesCached = Stats.BytesCached;
+}
 
-            // then use use periodSize / testDivisor
-            if (testDivisor > 1) {
-                if (FiniteWord_isSplat(*period, static_cast<unsigned int>(periodSize / testDivisor))) {
-                    auto modWord = FiniteWord_residue(*period, periodSize / testDivisor);
-                    *period = modWord;
+void FiniteWord_allocatorTrim() {
+    LimbAllocator_trim();
+}
 
-                    // recurse on compressedPeriod, but it is now smaller
-                    FiniteWord_compressPeriod(period);
-                    return;
-                }
-            }
+/// Whether word repeats every Distance bits, Distance divides Size
+/// Compares bits [Distance, Size) with bits [0, Size - Distance) a limb at a time
+static bool hasPeriod(FiniteWord *word, size_t Distance) {
+    auto Size = word->Size;
+    if (isSmall(word)) {
+        return rotateLeftSmall(word->Small, Size, Distance) == word->Small;
+    }
+    auto L = getLimbs(word);
+    auto Limbs = numLimbs(Size);
+    auto Count = Size - Distance;
+    for (size_t i = 0; i < Count; i += SMALL_WORD_BITS) {
+        auto Chunk = std::min(Count - i, SMALL_WORD_BITS);
+        if (readBits(L, Limbs, i, Chunk) != readBits(L, Limbs, Distance + i, Chunk)) {
+            return false;
         }
     }
+    return true;
+}
+
+/// Replace period with its smallest repeating unit
+/// The periods of a word that divide its size are exactly the multiples of the
+/// smallest one, so divide out each prime factor of the size for as long as
+/// the word still has the smaller period
+void FiniteWord_compressPeriod(FiniteWord **period) {
+    if ((*period)->Pattern) {
+        // a repeat has the same smallest repeating unit as its pattern
+        *period = (*period)->Pattern;
+    }
+    auto periodSize = (*period)->Size;
+    auto Minimal = periodSize;
+    auto Remaining = periodSize;
+    for (size_t Prime = 2; Prime * Prime <= Remaining; Prime++) {
+        if (Remaining % Prime != 0) {
+            continue;
+        }
+        while (Remaining % Prime == 0) {
+            Remaining /= Prime;
+        }
+        while (Minimal % Prime == 0 && hasPeriod(*period, Minimal / Prime)) {
+            Minimal /= Prime;
+        }
+    }
+    if (Remaining > 1) {
+        // the one prime factor larger than the square root
+        if (hasPeriod(*period, Minimal / Remaining)) {
+            Minimal /= Remaining;
+        }
+    }
+    if (Minimal != periodSize) {
+        *period = FiniteWord_residue(*period, Minimal);
+    }
 }
 
 //bool FiniteWord::isPeriodCompressed(const FiniteWord period) {
@@ -824,6 +2008,213 @@ void FiniteWord_multiplyPeriod(FiniteWord **period, size_t factor) {
     *period = FiniteWord_createFromRepsWord(factor, *period);
 }
 
+//
+// Periodic streams
+//
+// A period stands for that word repeated forever. Combining two of them bit by
+// bit gives a stream whose period divides the least common multiple of their
+// sizes, which for coprime sizes is their product. A PeriodicStream reads both
+// periods cyclically, 64 bits at a time, so the repeated words are never
+// built, and only the smallest repeating unit of the result is.
+//
+
+enum PeriodicCombine {
+    PERIODIC_OR,
+    PERIODIC_AND,
+    PERIODIC_XOR,
+    PERIODIC_PLUS
+};
+
+/// Periods shorter than this are widened first, so reading a limb of them
+/// takes a few pieces instead of one per copy
+static const size_t PERIODIC_MIN_BITS = 2 * SMALL_WORD_BITS;
+
+/// Count bits of word repeated forever, starting at Position < Size, Count <= 64
+static uint64_t readCyclicBits(FiniteWord *word, size_t Position, size_t Count) {
+    uint64_t Bits = 0;
+    for (size_t Read = 0; Read < Count;) {
+        auto Chunk = std::min(Count - Read, word->Size - Position);
+        Bits |= readWordBits(word, Position, Chunk) << Read;
+        Read += Chunk;
+        Position += Chunk;
+        if (Position == word->Size) {
+            Position = 0;
+        }
+    }
+    return Bits;
+}
+
+/// The same stream of bits as period repeated forever, in a word of at least
+/// PERIODIC_MIN_BITS bits
+static FiniteWord *widenPeriod(FiniteWord *period) {
+    if (period->Size >= PERIODIC_MIN_BITS) {
+        return period;
+    }
+    auto Repetitions = (PERIODIC_MIN_BITS + period->Size - 1) / period->Size;
+    auto Widened = FiniteWord_createFromRepsWord(Repetitions, period);
+    materialize(Widened);
+    return Widened;
+}
+
+struct PeriodicStream {
+    FiniteWord *A;
+    FiniteWord *B;
+    PeriodicCombine Combine;
+    size_t PositionA;
+    size_t PositionB;
+    uint64_t Carry;
+    
+    PeriodicStream(FiniteWord *A, FiniteWord *B, PeriodicCombine Combine, uint64_t Carry) :
+        A(widenPeriod(A)), B(widenPeriod(B)), Combine(Combine), PositionA(0), PositionB(0), Carry(Carry) {}
+    
+    /// The next Count bits, Count <= 64
+    uint64_t next(size_t Count) {
+        auto BitsA = readCyclicBits(A, PositionA, Count);
+        auto BitsB = readCyclicBits(B, PositionB, Count);
+        PositionA = (PositionA + Count) % A->Size;
+        PositionB = (PositionB + Count) % B->Size;
+        switch (Combine) {
+        case PERIODIC_OR:
+            return BitsA | BitsB;
+        case PERIODIC_AND:
+            return BitsA & BitsB;
+        case PERIODIC_XOR:
+            return BitsA ^ BitsB;
+        case PERIODIC_PLUS: {
+            auto Sum = BitsA + BitsB;
+            auto Overflow = Sum < BitsA;
+            auto Total = Sum + Carry;
+            Overflow |= Total < Sum;
+            if (Count < SMALL_WORD_BITS) {
+                // Total has at most Count + 1 bits
+                Carry = Total >> Count;
+                return Total & lowMask(Count);
+            }
+            Carry = Overflow;
+            return Total;
+        }
+        }
+        llvm_unreachable("fallthrough");
+    }
+    
+    void skip(size_t Count) {
+        if (Combine != PERIODIC_PLUS) {
+            PositionA = (PositionA + Count) % A->Size;
+            PositionB = (PositionB + Count) % B->Size;
+            return;
+        }
+        for (size_t Skipped = 0; Skipped < Count; Skipped += SMALL_WORD_BITS) {
+            next(std::min(Count - Skipped, SMALL_WORD_BITS));
+        }
+    }
+};
+
+/// The next Count bits of Stream as a word
+static FiniteWord *streamBits(PeriodicStream Stream, size_t Count) {
+    if (Count == 0) {
+        return FiniteWord_EMPTY;
+    }
+    std::vector<uint64_t> Limbs(numLimbs(Count));
+    for (size_t i = 0; i < Count; i += SMALL_WORD_BITS) {
+        Limbs[i / SMALL_WORD_BITS] = Stream.next(std::min(Count - i, SMALL_WORD_BITS));
+    }
+    return FiniteWord_createFromLimbs(Count, Limbs.data());
+}
+
+/// Whether Stream repeats every Distance bits, given that it repeats every
+/// Size bits and Distance divides Size
+static bool streamHasPeriod(const PeriodicStream &Stream, size_t Distance, size_t Size) {
+    auto Follow = Stream;
+    auto Lead = Stream;
+    Lead.skip(Distance);
+    auto Count = Size - Distance;
+    for (size_t i = 0; i < Count; i += SMALL_WORD_BITS) {
+        auto Chunk = std::min(Count - i, SMALL_WORD_BITS);
+        if (Follow.next(Chunk) != Lead.next(Chunk)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Smallest repeating unit of Stream, which repeats every Size bits
+/// Same search as FiniteWord_compressPeriod, mostly failing within the first limb
+static FiniteWord *streamPeriod(const PeriodicStream &Stream, size_t Size) {
+    auto Minimal = Size;
+    auto Remaining = Size;
+    for (size_t Prime = 2; Prime * Prime <= Remaining; Prime++) {
+        if (Remaining % Prime != 0) {
+            continue;
+        }
+        while (Remaining % Prime == 0) {
+            Remaining /= Prime;
+        }
+        while (Minimal % Prime == 0 && streamHasPeriod(Stream, Minimal / Prime, Minimal)) {
+            Minimal /= Prime;
+        }
+    }
+    if (Remaining > 1 && streamHasPeriod(Stream, Minimal / Remaining, Minimal)) {
+        Minimal /= Remaining;
+    }
+    return streamBits(Stream, Minimal);
+}
+
+static FiniteWord *periodCombine(FiniteWord *A, FiniteWord *B, PeriodicCombine Combine) {
+    assert(A->Size > 0 && B->Size > 0 && "Period size is 0");
+    auto Size = Math_lcm(A->Size, B->Size);
+    return streamPeriod(PeriodicStream(A, B, Combine, 0), Size);
+}
+
+FiniteWord *FiniteWord_periodOr(FiniteWord *A, FiniteWord *B) {
+    return periodCombine(A, B, PERIODIC_OR);
+}
+
+FiniteWord *FiniteWord_periodAnd(FiniteWord *A, FiniteWord *B) {
+    return periodCombine(A, B, PERIODIC_AND);
+}
+
+FiniteWord *FiniteWord_periodXor(FiniteWord *A, FiniteWord *B) {
+    return periodCombine(A, B, PERIODIC_XOR);
+}
+
+void FiniteWord_periodPlus(FiniteWord *A, FiniteWord *B, uint8_t Carry, FiniteWord **Prefix, FiniteWord **Period) {
+    assert(A->Size > 0 && B->Size > 0 && "Period size is 0");
+    assert(Carry <= 1 && "Carry is not a bit");
+    auto Size = Math_lcm(A->Size, B->Size);
+    PeriodicStream First(A, B, PERIODIC_PLUS, Carry);
+    auto Pass = First;
+    Pass.skip(Size);
+    if (Pass.Carry == Carry) {
+        *Prefix = FiniteWord_EMPTY;
+        *Period = streamPeriod(First, Size);
+        return;
+    }
+    
+    // The carry out of a pass is never less with a carry in of 1 than of 0, so
+    // the carry out of the first pass goes into and out of every later pass
+    PeriodicStream Second(A, B, PERIODIC_PLUS, Pass.Carry);
+    
+    // The first two passes give the same bits once their carries meet
+    auto X = First;
+    auto Y = Second;
+    size_t Settled = 0;
+    for (size_t i = 0; i < Size; i += SMALL_WORD_BITS) {
+        auto Chunk = std::min(Size - i, SMALL_WORD_BITS);
+        auto Diff = X.next(Chunk) ^ Y.next(Chunk);
+        if (Diff != 0) {
+            Settled = i + SMALL_WORD_BITS - llvm::countLeadingZeros(Diff);
+        }
+        if (X.Carry == Y.Carry) {
+            break;
+        }
+    }
+    assert(X.Carry == Y.Carry && "Carries of the passes did not meet");
+    
+    *Prefix = streamBits(First, Settled);
+    Second.skip(Settled);
+    *Period = streamPeriod(Second, Size);
+}
+
 //
 // Bitwise operations
 //
@@ -832,41 +2223,59 @@ void FiniteWord_multiplyPeriod(FiniteWord **period, size_t factor) {
 //    return ~L;
 //}
 
+void FiniteWord_orAssign(FiniteWord *Dest, FiniteWord *Src) {
+    assert(Src->Size <= Dest->Size && "Src is wider than Dest");
+    Dest->Hash = 0;
+    auto D = getLimbs(Dest);
+    auto S = getLimbs(Src);
+    BitKernels_or(D, D, S, numLimbs(Src->Size));
+}
+
+void FiniteWord_andAssign(FiniteWord *Dest, FiniteWord *Src) {
+    assert(Src->Size <= Dest->Size && "Src is wider than Dest");
+    Dest->Hash = 0;
+    auto D = getLimbs(Dest);
+    auto S = getLimbs(Src);
+    auto SrcLimbs = numLimbs(Src->Size);
+    auto DestLimbs = numLimbs(Dest->Size);
+    BitKernels_and(D, D, S, SrcLimbs);
+    // Src is zero-extended
+    for (size_t i = SrcLimbs; i < DestLimbs; i++) {
+        D[i] = 0;
+    }
+}
+
+void FiniteWord_xorAssign(FiniteWord *Dest, FiniteWord *Src) {
+    assert(Src->Size <= Dest->Size && "Src is wider than Dest");
+    Dest->Hash = 0;
+    auto D = getLimbs(Dest);
+    auto S = getLimbs(Src);
+    BitKernels_xor(D, D, S, numLimbs(Src->Size));
+}
+
 FiniteWord *FiniteWord_arrayOr(FiniteWord **Values, size_t Count) {
    assert(Count > 1 && "Vals does not contain more than one element");
-   std::vector<FiniteWord *> Vals(Values, Values + Count);
-   auto Iter = Vals.begin();
-   auto Val = FiniteWord_createFromFiniteWord(*Iter);
-   Iter++;
-   for (; Iter != Vals.end(); ++Iter) {
-       // maintain intuitive order
-       Val = FiniteWord_or(*Iter, Val);
+   auto Val = FiniteWord_createAccumulator(Values[0], FiniteWord_size(Values[0]));
+   for (size_t i = 1; i < Count; i++) {
+       FiniteWord_orAssign(Val, Values[i]);
    }
    return Val;
 }
 
 FiniteWord *FiniteWord_arrayAnd(FiniteWord **Values, size_t Count) {
    assert(Count > 1 && "Vals does not contain more than one element");
-   std::vector<FiniteWord *> Vals(Values, Values + Count);
-   auto Iter = Vals.begin();
-   auto Val = FiniteWord_createFromFiniteWord(*Iter);
-   Iter++;
-   for (; Iter != Vals.end(); ++Iter) {
-       // maintain intuitive order
-       Val = FiniteWord_and(*Iter, Val);
+   auto Val = FiniteWord_createAccumulator(Values[0], FiniteWord_size(Values[0]));
+   for (size_t i = 1; i < Count; i++) {
+       FiniteWord_andAssign(Val, Values[i]);
    }
    return Val;
 }
 
 FiniteWord *FiniteWord_arrayXor(FiniteWord **Values, size_t Count) {
    assert(Count > 1 && "Vals does not contain more than one element");
-   std::vector<FiniteWord *> Vals(Values, Values + Count);
-   auto Iter = Vals.begin();
-   auto Val = FiniteWord_createFromFiniteWord(*Iter);
-   Iter++;
-   for (; Iter != Vals.end(); ++Iter) {
-       // maintain intuitive order
-       Val = FiniteWord_xor(*Iter, Val);
+   auto Val = FiniteWord_createAccumulator(Values[0], FiniteWord_size(Values[0]));
+   for (size_t i = 1; i < Count; i++) {
+       FiniteWord_xorAssign(Val, Values[i]);
    }
    return Val;
 }
@@ -916,11 +2325,49 @@ FiniteWord *FiniteWord_arrayXor(FiniteWord **Values, size_t Count) {
 //    return FactoryFiniteWordImpl(Modded);
 //}
 
+void FiniteWord_addAssign(FiniteWord *Dest, FiniteWord *Src) {
+    assert(Src->Size <= Dest->Size && "Src is wider than Dest");
+    Dest->Hash = 0;
+    if (Src->Size == 0) {
+        return;
+    }
+    auto D = getLimbs(Dest);
+    auto S = getLimbs(Src);
+    auto SrcLimbs = numLimbs(Src->Size);
+    auto DestLimbs = numLimbs(Dest->Size);
+    uint64_t Carry = 0;
+    for (size_t i = 0; i < SrcLimbs; i++) {
+        auto Sum = D[i] + S[i];
+        auto Overflow = Sum < S[i];
+        D[i] = Sum + Carry;
+        Carry = Overflow | (D[i] < Sum);
+    }
+    for (size_t i = SrcLimbs; Carry && i < DestLimbs; i++) {
+        D[i]++;
+        Carry = (D[i] == 0);
+    }
+    D[DestLimbs - 1] &= topLimbMask(Dest->Size);
+}
+
+/// 3:2 compression of Sum + Carry + X back into Sum + Carry
+/// Only the lowest bit of the carry moves between limbs, so there is no carry chain
+static void carrySaveAdd(uint64_t *Sum, uint64_t *Carry, size_t Limbs, const uint64_t *X, size_t XLimbs) {
+    uint64_t Shifted = 0;
+    for (size_t i = 0; i < Limbs; i++) {
+        auto S = Sum[i];
+        auto C = Carry[i];
+        auto V = i < XLimbs ? X[i] : 0;
+        auto Majority = (S & C) | (S & V) | (C & V);
+        Sum[i] = S ^ C ^ V;
+        Carry[i] = (Majority << 1) | Shifted;
+        Shifted = Majority >> (SMALL_WORD_BITS - 1);
+    }
+    assert(Shifted == 0 && "Carry-save sum overflowed");
+}
+
 void FiniteWord_arrayPlus(FiniteWord **Values, size_t Count, FiniteWord **Hi, FiniteWord **Lo) {
    assert(Count > 1 && "Vals does not contain more than one element");
-   std::vector<FiniteWord *> Vals(Values, Values + Count);
-   auto Iter = Vals.begin();
-   size_t OldWidth = FiniteWord_size(*Iter);
+   size_t OldWidth = FiniteWord_size(Values[0]);
    if (OldWidth == 0) {
        // Still return 1 carry bit, even if the words are empty
        *Hi = FiniteWord_ZERO_1BIT;
@@ -928,22 +2375,34 @@ void FiniteWord_arrayPlus(FiniteWord **Values, size_t Count, FiniteWord **Hi, Fi
        return;
    }
 
-   auto CarryWidth = Math_bitLength(Vals.size() - 1);
+   auto CarryWidth = Math_bitLength(Count - 1);
 
    size_t NewWidth = OldWidth + CarryWidth;
-   auto APVal = FiniteWord_zext(*Iter, static_cast<unsigned int>(NewWidth));
-   Iter++;
-    
-   for (; Iter != Vals.end(); ++Iter) {
-       assert(FiniteWord_size(*Iter) == OldWidth && "Sizes not equal");
-       // maintain intuitive order
-       auto NextVal = FiniteWord_zext(*Iter, static_cast<unsigned int>(NewWidth));
-       APVal = FiniteWord_add(NextVal, APVal);
+   if (NewWidth <= SMALL_WORD_BITS) {
+       // the sum cannot overflow NewWidth bits
+       uint64_t Sum = 0;
+       for (size_t i = 0; i < Count; i++) {
+           assert(FiniteWord_size(Values[i]) == OldWidth && "Sizes not equal");
+           Sum += Values[i]->Small;
+       }
+       *Lo = FiniteWord_createFromSmall(OldWidth, Sum);
+       *Hi = FiniteWord_createFromSmall(CarryWidth, Sum >> OldWidth);
+       return;
    }
 
-   *Lo = FiniteWord_residue(APVal, static_cast<unsigned int>(OldWidth));
-   *Hi = FiniteWord_lshr(APVal, static_cast<unsigned int>(OldWidth));
-   *Hi = FiniteWord_residue(*Hi, static_cast<unsigned int>(CarryWidth));
+   // keep the running total as Sum + Carry, and only propagate carries once at the end
+   auto APVal = FiniteWord_createAccumulator(Values[0], NewWidth);
+   auto Sum = getLimbs(APVal);
+   auto Limbs = numLimbs(NewWidth);
+   std::vector<uint64_t> Carry(Limbs, 0);
+   for (size_t i = 1; i < Count; i++) {
+       assert(FiniteWord_size(Values[i]) == OldWidth && "Sizes not equal");
+       carrySaveAdd(Sum, Carry.data(), Limbs, getLimbs(Values[i]), numLimbs(OldWidth));
+   }
+   LimbArithmetic_addInto(Sum, Limbs, Carry.data(), Limbs);
+
+   *Lo = FiniteWord_residue(APVal, OldWidth);
+   *Hi = FiniteWord_shiftRight(APVal, OldWidth);
 }
 
 void FiniteWord_arraySubtract(FiniteWord **Values, size_t Count, FiniteWord **Hi, FiniteWord **Lo) {
@@ -962,6 +2421,12 @@ void FiniteWord_arraySubtract(FiniteWord **Values, size_t Count, FiniteWord **Hi
     auto BorrowWidth = 1;
 
     size_t NewWidth = OldWidth + BorrowWidth;
+    if (NewWidth <= SMALL_WORD_BITS) {
+        auto Difference = (L->Small - R->Small) & lowMask(NewWidth);
+        *Hi = FiniteWord_createFromSmall(BorrowWidth, Difference >> OldWidth);
+        *Lo = FiniteWord_createFromSmall(OldWidth, Difference);
+        return;
+    }
     auto NewLVal = FiniteWord_zext(L, NewWidth);
     auto NewRVal = FiniteWord_zext(R, NewWidth);
 
@@ -973,11 +2438,42 @@ void FiniteWord_arraySubtract(FiniteWord **Values, size_t Count, FiniteWord **Hi
     *Lo = LoAPInt;
 }
 
+void FiniteWord_multiplyAssign(FiniteWord *Dest, FiniteWord *Src) {
+    assert(Src->Size <= Dest->Size && "Src is wider than Dest");
+    Dest->Hash = 0;
+    if (isSmall(Dest)) {
+        Dest->Small = (Dest->Small * Src->Small) & lowMask(Dest->Size);
+        return;
+    }
+    
+    auto D = getLimbs(Dest);
+    auto DestLimbs = numLimbs(Dest->Size);
+    LimbMultiply_multiply(D, DestLimbs, D, DestLimbs, getLimbs(Src), numLimbs(Src->Size));
+    D[DestLimbs - 1] &= topLimbMask(Dest->Size);
+}
+
+/// Product of Values[Begin, End), each Width bits, in numLimbs((End - Begin) * Width) limbs
+/// The halves are multiplied at the width of their own product, so each level
+/// of the tree costs one multiply at the final width instead of every step of
+/// a fold paying for it
+static LimbVector productTree(FiniteWord **Values, size_t Begin, size_t End, size_t Width) {
+    if (End - Begin == 1) {
+        LimbVector Leaf(numLimbs(Width));
+        FiniteWord_copyLimbs(Values[Begin], Leaf.data());
+        return Leaf;
+    }
+    auto Middle = Begin + (End - Begin) / 2;
+    auto Left = productTree(Values, Begin, Middle, Width);
+    auto Right = productTree(Values, Middle, End, Width);
+    // the product of k Width-bit words fits in k * Width bits, nothing is cut off
+    LimbVector Product(numLimbs((End - Begin) * Width));
+    LimbMultiply_multiply(Product.data(), Product.size(), Left.data(), Left.size(), Right.data(), Right.size());
+    return Product;
+}
+
 void FiniteWord_arrayTimes(FiniteWord **Values, size_t Count, FiniteWord **Hi, FiniteWord **Lo) {
    assert(Count > 1 && "Vals does not contain more than one element");
-   std::vector<FiniteWord *> Vals(Values, Values + Count);
-   auto Iter = Vals.begin();
-   size_t OldWidth = FiniteWord_size(*Iter);
+   size_t OldWidth = FiniteWord_size(Values[0]);
    if (OldWidth == 0) {
        // Still return 1 Hi bit, even if the words are empty
        *Hi = FiniteWord_ZERO_1BIT;
@@ -985,17 +2481,26 @@ void FiniteWord_arrayTimes(FiniteWord **Values, size_t Count, FiniteWord **Hi, F
        return;
    }
 
-   size_t NewWidth = OldWidth * Vals.size();
-   auto APVal = FiniteWord_zext(*Iter, static_cast<unsigned int>(NewWidth));
-   Iter++;
+   size_t NewWidth = OldWidth * Count;
+   if (NewWidth <= SMALL_WORD_BITS) {
+       // the product cannot overflow NewWidth bits
+       uint64_t Product = 1;
+       for (size_t i = 0; i < Count; i++) {
+           assert(FiniteWord_size(Values[i]) == OldWidth && "Sizes not equal");
+           Product *= Values[i]->Small;
+       }
+       *Hi = FiniteWord_createFromSmall(NewWidth - OldWidth, Product >> OldWidth);
+       *Lo = FiniteWord_createFromSmall(OldWidth, Product);
+       return;
+   }
 
-   for (; Iter != Vals.end(); ++Iter) {
-       assert(FiniteWord_size(*Iter) == OldWidth && "Sizes not equal");
-       // maintain intuitive order
-       APVal = FiniteWord_multiply(FiniteWord_zext(*Iter, static_cast<unsigned int>(NewWidth)), APVal);
+   for (size_t i = 1; i < Count; i++) {
+       assert(FiniteWord_size(Values[i]) == OldWidth && "Sizes not equal");
    }
-   *Hi = FiniteWord_residue(FiniteWord_lshr(APVal, static_cast<unsigned int>(OldWidth)), static_cast<unsigned int>(OldWidth * (Vals.size() - 1)));
-   *Lo = FiniteWord_residue(APVal, static_cast<unsigned int>(OldWidth));
+   auto Product = productTree(Values, 0, Count, OldWidth);
+   auto APVal = FiniteWord_createFromLimbs(NewWidth, Product.data());
+   *Hi = FiniteWord_shiftRight(APVal, OldWidth);
+   *Lo = FiniteWord_residue(APVal, OldWidth);
 }
 
 //void FiniteWord::divide(FiniteWord Dividend, FiniteWord Divisor, FiniteWord& Quotient, FiniteWord& Remainder) {
@@ -0,0 +1,170 @@
+//===------ FixedWord.h - Kernels for words of a fixed width --------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "LimbArithmetic.h"
+
+#include <cstddef> // for size_t
+#include <cstdint>
+
+//
+// Arithmetic on N-bit unsigned integers stored as arrays of 64-bit limbs,
+// least significant first, with the limb count known at compile time and
+// every loop unrolled.
+//
+// FiniteWord dispatches to these for the common wide widths with
+// FIXEDWORD_DISPATCH. Words of up to 64 bits are already a single machine
+// word, and other widths use the generic limb and APInt code.
+//
+
+/// Calls Body(I) for I from Begin up to End, unrolled
+template <size_t Begin, size_t End>
+struct FixedWordUnroll {
+    template <typename Body>
+    static inline void run(Body &B) {
+        B(Begin);
+        FixedWordUnroll<Begin + 1, End>::run(B);
+    }
+};
+
+template <size_t End>
+struct FixedWordUnroll<End, End> {
+    template <typename Body>
+    static inline void run(Body &) {}
+};
+
+template <size_t N>
+struct FixedWord {
+    static constexpr size_t Limbs = (N + 63) / 64;
+    static constexpr uint64_t TopMask = N % 64 == 0 ? ~UINT64_C(0) : (UINT64_C(1) << (N % 64)) - 1;
+
+    /// D = A + B mod 2^N
+    static inline void add(uint64_t *D, const uint64_t *A, const uint64_t *B) {
+        uint64_t Carry = 0;
+        auto Step = [&](size_t i) {
+            auto Sum = A[i] + Carry;
+            Carry = Sum < Carry;
+            Sum += B[i];
+            Carry += Sum < B[i];
+            D[i] = Sum;
+        };
+        FixedWordUnroll<0, Limbs>::run(Step);
+        D[Limbs - 1] &= TopMask;
+    }
+
+    /// D = A - B mod 2^N
+    static inline void subtract(uint64_t *D, const uint64_t *A, const uint64_t *B) {
+        uint64_t Borrow = 0;
+        auto Step = [&](size_t i) {
+            auto Diff = A[i] - B[i];
+            auto NewBorrow = static_cast<uint64_t>(A[i] < B[i]) | static_cast<uint64_t>(Diff < Borrow);
+            D[i] = Diff - Borrow;
+            Borrow = NewBorrow;
+        };
+        FixedWordUnroll<0, Limbs>::run(Step);
+        D[Limbs - 1] &= TopMask;
+    }
+
+    /// D = -A mod 2^N
+    static inline void negate(uint64_t *D, const uint64_t *A) {
+        uint64_t Carry = 1;
+        auto Step = [&](size_t i) {
+            auto Sum = ~A[i] + Carry;
+            Carry = Sum < Carry;
+            D[i] = Sum;
+        };
+        FixedWordUnroll<0, Limbs>::run(Step);
+        D[Limbs - 1] &= TopMask;
+    }
+
+    /// D = A * B mod 2^N, D may not be A or B
+    static inline void multiply(uint64_t *D, const uint64_t *A, const uint64_t *B) {
+        auto Clear = [&](size_t i) { D[i] = 0; };
+        FixedWordUnroll<0, Limbs>::run(Clear);
+        // row i adds A * B[i] into D[i..Limbs), dropping what goes above
+        auto Row = [&](size_t i) {
+            uint64_t Carry = 0;
+            auto Column = [&](size_t j) {
+                if (i + j < Limbs) {
+                    uint64_t Hi;
+                    auto Lo = LimbArithmetic_multiplyWide(A[j], B[i], &Hi);
+                    Lo += D[i + j];
+                    Hi += Lo < D[i + j];
+                    Lo += Carry;
+                    Hi += Lo < Carry;
+                    D[i + j] = Lo;
+                    Carry = Hi;
+                }
+            };
+            FixedWordUnroll<0, Limbs>::run(Column);
+        };
+        FixedWordUnroll<0, Limbs>::run(Row);
+        D[Limbs - 1] &= TopMask;
+    }
+
+    /// D = A << Amount mod 2^N
+    static inline void shiftLeft(uint64_t *D, const uint64_t *A, size_t Amount) {
+        auto LimbShift = Amount / 64;
+        auto BitShift = Amount % 64;
+        // from the top down, so D may be A
+        auto Step = [&](size_t k) {
+            auto i = Limbs - 1 - k;
+            uint64_t Bits = 0;
+            if (i >= LimbShift) {
+                Bits = A[i - LimbShift] << BitShift;
+                if (BitShift != 0 && i > LimbShift) {
+                    Bits |= A[i - LimbShift - 1] >> (64 - BitShift);
+                }
+            }
+            D[i] = Bits;
+        };
+        FixedWordUnroll<0, Limbs>::run(Step);
+        D[Limbs - 1] &= TopMask;
+    }
+
+    /// D = A >> Amount, D may be A
+    static inline void shiftRight(uint64_t *D, const uint64_t *A, size_t Amount) {
+        auto LimbShift = Amount / 64;
+        auto BitShift = Amount % 64;
+        auto Step = [&](size_t i) {
+            uint64_t Bits = 0;
+            if (i + LimbShift < Limbs) {
+                Bits = A[i + LimbShift] >> BitShift;
+                if (BitShift != 0 && i + LimbShift + 1 < Limbs) {
+                    Bits |= A[i + LimbShift + 1] << (64 - BitShift);
+                }
+            }
+            D[i] = Bits;
+        };
+        FixedWordUnroll<0, Limbs>::run(Step);
+    }
+
+    /// -1, 0, or 1
+    static inline int compare(const uint64_t *A, const uint64_t *B) {
+        int Result = 0;
+        auto Step = [&](size_t k) {
+            auto i = Limbs - 1 - k;
+            if (Result == 0 && A[i] != B[i]) {
+                Result = A[i] < B[i] ? -1 : 1;
+            }
+        };
+        FixedWordUnroll<0, Limbs>::run(Step);
+        return Result;
+    }
+};
+
+/// return Kernel<N>(Args...) if Size is one of the FixedWord widths
+#define FIXEDWORD_DISPATCH(Size, Kernel, ...) \
+    switch (Size) { \
+    case 128: return Kernel<128>(__VA_ARGS__); \
+    case 256: return Kernel<256>(__VA_ARGS__); \
+    case 512: return Kernel<512>(__VA_ARGS__); \
+    default: break; \
+    }
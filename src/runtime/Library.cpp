@@ -7,6 +7,7 @@
 #include "../common/BuiltinSymbol.h"
 #include "../common/BuiltinFunction.h"
 #include "../common/List.h"
+#include "../common/WordVector.h"
 
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
@@ -134,6 +135,8 @@ TuppenceValue *Library_rationalize(TuppenceValue **Args, size_t Count) {
 //
 // size(list)
 //
+// size(vector)
+//
 TuppenceValue *Library_size(TuppenceValue **Args, size_t Count) {
 
     auto ArgsCasted = std::vector<TuppenceValue *>(Args, Args + Count);
@@ -160,12 +163,20 @@ TuppenceValue *Library_size(TuppenceValue **Args, size_t Count) {
 
         auto RationalSize = RationalWord_createFromVal(64, Size, true);
 
+        return Value_createFromRationalWord(RationalSize);
+    } else if (Val->tag == WordVectorTag) {
+        auto VectorVal = Val->vector;
+
+        auto Size = WordVector_count(VectorVal);
+
+        auto RationalSize = RationalWord_createFromVal(64, Size, true);
+
         return Value_createFromRationalWord(RationalSize);
     }
     else {
         char *str;
         Value_CreateString(Val, &str);
-        return Value_createFromError((std::string("Expected FiniteWord, RationalWord, or List: ") + str).c_str());
+        return Value_createFromError((std::string("Expected FiniteWord, RationalWord, List, or WordVector: ") + str).c_str());
     }
 }
 
@@ -253,3 +264,52 @@ TuppenceValue *Library_denominator(TuppenceValue **Args, size_t Count) {
     }
 }
 
+
+//
+// vector(list) packs a list of FiniteWords of the same size
+//
+// vector(finite, finite, ...)
+//
+TuppenceValue *Library_vector(TuppenceValue **Args, size_t Count) {
+
+    if (Count == 0) {
+        return Value_createFromError("vector takes 1 or more args");
+    }
+
+    List *ListVal;
+    if (Count == 1 && Args[0]->tag == ListTag) {
+        ListVal = Args[0]->list;
+    } else {
+        ListVal = List_createFromVals(Args, Count);
+    }
+
+    auto Vector = WordVector_createFromList(ListVal);
+    if (!Vector) {
+        char *str;
+        List_newString(ListVal, &str);
+        return Value_createFromError((std::string("Expected FiniteWords with the same size: ") + str).c_str());
+    }
+
+    return Value_createFromWordVector(Vector);
+}
+
+//
+// list(vector)
+//
+TuppenceValue *Library_list(TuppenceValue **Args, size_t Count) {
+
+    if (Count != 1) {
+        return Value_createFromError("list takes 1 arg");
+    }
+
+    auto Val = Args[0];
+
+    if (Val->tag == WordVectorTag) {
+        return Value_createFromList(WordVector_toList(Val->vector));
+    }
+    else {
+        char *str;
+        Value_CreateString(Val, &str);
+        return Value_createFromError((std::string("Expected WordVector: ") + str).c_str());
+    }
+}
@@ -0,0 +1,137 @@
+//===------ LimbAllocator.cpp ---------------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "LimbAllocator.h"
+
+#include "llvm/Support/MathExtras.h"
+
+#include <cassert>
+#include <mutex>
+#include <new>
+
+#if !defined(_WIN32)
+#define LIMBALLOCATOR_MMAP 1
+#include <sys/mman.h>
+#endif
+
+/// Arrays of at least this many bytes are mapped and pooled
+static const size_t LARGE_BYTES = (size_t)1 << 20;
+
+/// Transparent huge page size on x86-64 and most AArch64 kernels
+static const size_t HUGE_PAGE_BYTES = (size_t)2 << 20;
+
+/// Free lists stop growing past this many bytes, released arrays are unmapped
+static const size_t MAX_CACHED_BYTES = (size_t)256 << 20;
+
+static const size_t SIZE_CLASSES = 64;
+
+static std::mutex Lock;
+static std::vector<void *> FreeLists[SIZE_CLASSES];
+static LimbAllocatorStats Stats;
+
+/// log2 of the bytes of the size class holding Bytes
+static inline size_t sizeClass(size_t Bytes) {
+    return llvm::Log2_64_Ceil(Bytes);
+}
+
+static void *mapBytes(size_t Bytes) {
+#if LIMBALLOCATOR_MMAP
+    // over-map so the array can start on a huge page boundary
+    auto Extra = Bytes >= HUGE_PAGE_BYTES ? HUGE_PAGE_BYTES : 0;
+    auto Mapped = mmap(nullptr, Bytes + Extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (Mapped == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    auto Start = reinterpret_cast<uintptr_t>(Mapped);
+    auto Aligned = Extra == 0 ? Start : (Start + HUGE_PAGE_BYTES - 1) & ~(uintptr_t)(HUGE_PAGE_BYTES - 1);
+    if (Aligned != Start) {
+        munmap(Mapped, Aligned - Start);
+    }
+    if (Aligned + Bytes != Start + Bytes + Extra) {
+        munmap(reinterpret_cast<void *>(Aligned + Bytes), Start + Bytes + Extra - (Aligned + Bytes));
+    }
+#if defined(MADV_HUGEPAGE)
+    madvise(reinterpret_cast<void *>(Aligned), Bytes, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<void *>(Aligned);
+#else
+    return ::operator new(Bytes);
+#endif
+}
+
+static void unmapBytes(void *Ptr, size_t Bytes) {
+#if LIMBALLOCATOR_MMAP
+    munmap(Ptr, Bytes);
+#else
+    ::operator delete(Ptr);
+#endif
+}
+
+uint64_t *LimbAllocator_allocate(size_t Count) {
+    auto Bytes = Count * sizeof(uint64_t);
+    if (Bytes < LARGE_BYTES) {
+        return static_cast<uint64_t *>(::operator new(Bytes));
+    }
+
+    auto Class = sizeClass(Bytes);
+    auto ClassBytes = (size_t)1 << Class;
+    std::lock_guard<std::mutex> Guard(Lock);
+    Stats.Allocations++;
+    Stats.BytesInUse += ClassBytes;
+    auto &FreeList = FreeLists[Class];
+    if (!FreeList.empty()) {
+        auto Ptr = FreeList.back();
+        FreeList.pop_back();
+        Stats.Reuses++;
+        Stats.BytesCached -= ClassBytes;
+        return static_cast<uint64_t *>(Ptr);
+    }
+    auto Ptr = mapBytes(ClassBytes);
+    Stats.BytesMapped += ClassBytes;
+    return static_cast<uint64_t *>(Ptr);
+}
+
+void LimbAllocator_release(uint64_t *Limbs, size_t Count) {
+    auto Bytes = Count * sizeof(uint64_t);
+    if (Bytes < LARGE_BYTES) {
+        ::operator delete(Limbs);
+        return;
+    }
+
+    auto Class = sizeClass(Bytes);
+    auto ClassBytes = (size_t)1 << Class;
+    std::lock_guard<std::mutex> Guard(Lock);
+    assert(Stats.BytesInUse >= ClassBytes && "Releasing more than was allocated");
+    Stats.BytesInUse -= ClassBytes;
+    if (Stats.BytesCached + ClassBytes > MAX_CACHED_BYTES) {
+        unmapBytes(Limbs, ClassBytes);
+        Stats.BytesMapped -= ClassBytes;
+        return;
+    }
+    FreeLists[Class].push_back(Limbs);
+    Stats.BytesCached += ClassBytes;
+}
+
+LimbAllocatorStats LimbAllocator_stats() {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Stats;
+}
+
+void LimbAllocator_trim() {
+    std::lock_guard<std::mutex> Guard(Lock);
+    for (size_t Class = 0; Class < SIZE_CLASSES; Class++) {
+        auto ClassBytes = (size_t)1 << Class;
+        for (auto Ptr : FreeLists[Class]) {
+            unmapBytes(Ptr, ClassBytes);
+            Stats.BytesMapped -= ClassBytes;
+            Stats.BytesCached -= ClassBytes;
+        }
+        FreeLists[Class].clear();
+    }
+}
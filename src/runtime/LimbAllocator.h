@@ -0,0 +1,81 @@
+//===------ LimbAllocator.h - Size-classed storage for large limb arrays --===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <vector>
+
+//
+// Storage for the limb arrays of multi-megabit intermediate results.
+//
+// Small arrays come from operator new. Large arrays are rounded up to a power
+// of two, mapped directly with mmap and marked for transparent huge pages, and
+// put on a free list for their size class when released, so that the next
+// kernel needing that much scratch reuses the pages instead of faulting in
+// fresh ones.
+//
+
+/// Count limbs, not initialized
+uint64_t *LimbAllocator_allocate(size_t Count);
+
+/// Count is the same as when allocated
+void LimbAllocator_release(uint64_t *Limbs, size_t Count);
+
+struct LimbAllocatorStats {
+    /// Large arrays handed out
+    uint64_t Allocations;
+    /// Of those, how many came from a free list
+    uint64_t Reuses;
+    /// Bytes currently mapped, in use or cached
+    uint64_t BytesMapped;
+    /// Bytes currently handed out
+    uint64_t BytesInUse;
+    /// Bytes currently on free lists
+    uint64_t BytesCached;
+};
+
+LimbAllocatorStats LimbAllocator_stats();
+
+/// Unmap everything on the free lists
+void LimbAllocator_trim();
+
+/// Allocator for std::vector that draws from LimbAllocator
+template <typename T>
+struct LimbPoolAllocator {
+    typedef T value_type;
+
+    LimbPoolAllocator() {}
+
+    template <typename U>
+    LimbPoolAllocator(const LimbPoolAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        static_assert(sizeof(T) == sizeof(uint64_t), "LimbPoolAllocator is for limbs");
+        return reinterpret_cast<T *>(LimbAllocator_allocate(n));
+    }
+
+    void deallocate(T *p, size_t n) {
+        LimbAllocator_release(reinterpret_cast<uint64_t *>(p), n);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const LimbPoolAllocator<T> &, const LimbPoolAllocator<U> &) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const LimbPoolAllocator<T> &, const LimbPoolAllocator<U> &) {
+    return false;
+}
+
+/// Scratch limbs for the arithmetic kernels
+typedef std::vector<uint64_t, LimbPoolAllocator<uint64_t>> LimbVector;
@@ -0,0 +1,132 @@
+//===------ LimbArithmetic.h - Helpers on limb arrays ---------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cassert>
+#include <cstddef> // for size_t
+#include <cstdint>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+//
+// Small helpers on unsigned integers stored as arrays of 64-bit limbs, least
+// significant first, shared by the LimbMultiply, LimbDivide, and LimbGcd engines
+//
+
+/// A * B, returning the low limb and storing the high limb in Hi
+static inline uint64_t LimbArithmetic_multiplyWide(uint64_t A, uint64_t B, uint64_t *Hi) {
+#if defined(__SIZEOF_INT128__)
+    auto Product = static_cast<unsigned __int128>(A) * B;
+    *Hi = static_cast<uint64_t>(Product >> 64);
+    return static_cast<uint64_t>(Product);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(A, B, Hi);
+#else
+    // schoolbook on 32-bit halves
+    auto ALo = A & 0xffffffffULL;
+    auto AHi = A >> 32;
+    auto BLo = B & 0xffffffffULL;
+    auto BHi = B >> 32;
+    auto LoLo = ALo * BLo;
+    auto Middle = AHi * BLo + (LoLo >> 32);
+    auto Cross = ALo * BHi + (Middle & 0xffffffffULL);
+    *Hi = AHi * BHi + (Middle >> 32) + (Cross >> 32);
+    return (Cross << 32) | (LoLo & 0xffffffffULL);
+#endif
+}
+
+/// (Hi:Lo) / Divisor, Hi < Divisor so the quotient fits in a limb
+/// Stores the remainder in Remainder
+static inline uint64_t LimbArithmetic_divideWide(uint64_t Hi, uint64_t Lo, uint64_t Divisor, uint64_t *Remainder) {
+    assert(Hi < Divisor && "Quotient does not fit in a limb");
+#if defined(__SIZEOF_INT128__)
+    auto Dividend = (static_cast<unsigned __int128>(Hi) << 64) | Lo;
+    auto Quotient = static_cast<uint64_t>(Dividend / Divisor);
+    *Remainder = Lo - Quotient * Divisor;
+    return Quotient;
+#elif defined(_MSC_VER) && defined(_M_X64) && _MSC_VER >= 1920
+    return _udiv128(Hi, Lo, Divisor, Remainder);
+#else
+    // restoring division, one quotient bit at a time
+    uint64_t Quotient = 0;
+    for (auto i = 0; i < 64; i++) {
+        auto Top = Hi >> 63;
+        Hi = (Hi << 1) | (Lo >> 63);
+        Lo <<= 1;
+        Quotient <<= 1;
+        if (Top != 0 || Hi >= Divisor) {
+            Hi -= Divisor;
+            Quotient |= 1;
+        }
+    }
+    *Remainder = Hi;
+    return Quotient;
+#endif
+}
+
+/// Count without the zero limbs at the top
+static inline size_t LimbArithmetic_activeLimbs(const uint64_t *A, size_t Count) {
+    while (Count > 0 && A[Count - 1] == 0) {
+        Count--;
+    }
+    return Count;
+}
+
+/// Compare active limbs, -1, 0, or 1
+static inline int LimbArithmetic_compare(const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    if (ACount != BCount) {
+        return ACount < BCount ? -1 : 1;
+    }
+    for (auto i = ACount; i-- > 0;) {
+        if (A[i] != B[i]) {
+            return A[i] < B[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/// A += B, BCount <= ACount
+/// Returns the carry out of the top of A
+static inline uint64_t LimbArithmetic_addInto(uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    assert(BCount <= ACount && "B is longer than A");
+    uint64_t Carry = 0;
+    size_t i = 0;
+    for (; i < BCount; i++) {
+        auto Sum = A[i] + Carry;
+        Carry = Sum < Carry;
+        Sum += B[i];
+        Carry += Sum < B[i];
+        A[i] = Sum;
+    }
+    for (; Carry != 0 && i < ACount; i++) {
+        A[i]++;
+        Carry = A[i] == 0;
+    }
+    return Carry;
+}
+
+/// A -= B, A >= B
+static inline void LimbArithmetic_subtractFrom(uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    uint64_t Borrow = 0;
+    size_t i = 0;
+    for (; i < BCount; i++) {
+        auto Diff = A[i] - B[i];
+        auto NewBorrow = static_cast<uint64_t>(A[i] < B[i]) | static_cast<uint64_t>(Diff < Borrow);
+        A[i] = Diff - Borrow;
+        Borrow = NewBorrow;
+    }
+    for (; Borrow != 0 && i < ACount; i++) {
+        Borrow = A[i] == 0;
+        A[i]--;
+    }
+    assert(Borrow == 0 && "Subtracting a larger number");
+}
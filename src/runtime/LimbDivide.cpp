@@ -0,0 +1,354 @@
+//===------ LimbDivide.cpp ------------------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "LimbDivide.h"
+
+#include "LimbAllocator.h"
+#include "LimbArithmetic.h"
+#include "LimbMultiply.h"
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+/// Divisors of at least this many limbs use a Newton reciprocal, smaller ones
+/// APInt's long division
+static const size_t NEWTON_THRESHOLD = 512;
+
+/// Reciprocals of at most this many limbs are computed directly
+static const size_t RECIPROCAL_BASE_LIMBS = 2;
+
+typedef LimbVector Limbs;
+
+static inline size_t numLimbs(size_t Bits) {
+    return (Bits + 63) / 64;
+}
+
+static void trim(Limbs &A) {
+    A.resize(LimbArithmetic_activeLimbs(A.data(), A.size()));
+}
+
+static int compare(const Limbs &A, const Limbs &B) {
+    return LimbArithmetic_compare(A.data(), LimbArithmetic_activeLimbs(A.data(), A.size()),
+                                  B.data(), LimbArithmetic_activeLimbs(B.data(), B.size()));
+}
+
+/// A * B, with ACount + BCount limbs
+static Limbs multiply(const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    Limbs Product(ACount + BCount);
+    LimbMultiply_multiply(Product.data(), Product.size(), A, ACount, B, BCount);
+    return Product;
+}
+
+/// Count bits of A starting at bit Offset, into the zeroed numLimbs(Count) limbs of Out
+static void extractBits(const uint64_t *A, size_t ACount, size_t Offset, size_t Count, uint64_t *Out) {
+    auto OutLimbs = numLimbs(Count);
+    for (size_t i = 0; i < OutLimbs; i++) {
+        auto Index = Offset / 64 + i;
+        auto Shift = Offset % 64;
+        if (Index >= ACount) {
+            break;
+        }
+        auto Bits = A[Index] >> Shift;
+        if (Shift != 0 && Index + 1 < ACount) {
+            Bits |= A[Index + 1] << (64 - Shift);
+        }
+        Out[i] = Bits;
+    }
+    if (Count % 64 != 0) {
+        Out[OutLimbs - 1] &= (UINT64_C(1) << (Count % 64)) - 1;
+    }
+}
+
+/// OR the Count bits of In into A starting at bit Offset
+static void depositBits(uint64_t *A, size_t ACount, size_t Offset, const uint64_t *In, size_t Count) {
+    auto InLimbs = numLimbs(Count);
+    for (size_t i = 0; i < InLimbs; i++) {
+        auto Index = Offset / 64 + i;
+        auto Shift = Offset % 64;
+        if (Index >= ACount) {
+            break;
+        }
+        A[Index] |= In[i] << Shift;
+        if (Shift != 0 && Index + 1 < ACount) {
+            A[Index + 1] |= In[i] >> (64 - Shift);
+        }
+    }
+}
+
+/// A << Shift, Shift < 64, with one more limb than A
+static Limbs shiftLeftSmall(const uint64_t *A, size_t ACount, unsigned Shift) {
+    Limbs Res(ACount + 1, 0);
+    for (size_t i = 0; i < ACount; i++) {
+        Res[i] |= A[i] << Shift;
+        if (Shift != 0) {
+            Res[i + 1] = A[i] >> (64 - Shift);
+        }
+    }
+    return Res;
+}
+
+/// Whether the Bits low bits of A are all ones and nothing above them is set
+static bool isAllOnes(const uint64_t *A, size_t ACount, size_t Bits) {
+    if (numLimbs(Bits) != ACount) {
+        return false;
+    }
+    for (size_t i = 0; i + 1 < ACount; i++) {
+        if (A[i] != ~UINT64_C(0)) {
+            return false;
+        }
+    }
+    auto TopBits = Bits - 64 * (ACount - 1);
+    auto TopMask = TopBits == 64 ? ~UINT64_C(0) : (UINT64_C(1) << TopBits) - 1;
+    return A[ACount - 1] == TopMask;
+}
+
+static void store(uint64_t *Dest, size_t DestCount, const Limbs &Res) {
+    if (!Dest) {
+        return;
+    }
+    auto Count = LimbArithmetic_activeLimbs(Res.data(), Res.size());
+    assert(Count <= DestCount && "Result does not fit");
+    std::copy(Res.begin(), Res.begin() + Count, Dest);
+    std::fill(Dest + Count, Dest + DestCount, 0);
+}
+
+//
+// Divisor 2^k - 1
+// 2^k is 1 modulo the divisor, so a step of long division in base 2^k with
+// remainder r < 2^k - 1 and next digit d gives quotient digit r or r + 1 and
+// new remainder r + d, folded back below 2^k - 1
+//
+
+static void divideAllOnes(Limbs &Q, Limbs &R, const uint64_t *A, size_t ACount, size_t k) {
+    auto L = numLimbs(k + 1);
+    auto Digits = (ACount * 64 + k - 1) / k;
+    Q.assign(ACount, 0);
+    R.assign(L, 0);
+    Limbs Sum(L);
+    Limbs Digit(L);
+    const uint64_t One = 1;
+    for (auto i = Digits; i-- > 0;) {
+        std::fill(Sum.begin(), Sum.end(), 0);
+        extractBits(A, ACount, i * k, k, Sum.data());
+        LimbArithmetic_addInto(Sum.data(), L, R.data(), L);
+
+        // the sum is less than 2 * (2^k - 1), so it wraps at most once
+        auto Wrap = (Sum[k / 64] >> (k % 64)) & 1;
+        auto Full = !Wrap && isAllOnes(Sum.data(), LimbArithmetic_activeLimbs(Sum.data(), L), k);
+
+        Digit = R;
+        if (Wrap || Full) {
+            LimbArithmetic_addInto(Digit.data(), L, &One, 1);
+        }
+        depositBits(Q.data(), ACount, i * k, Digit.data(), k);
+
+        R = Sum;
+        if (Wrap) {
+            R[k / 64] &= ~(UINT64_C(1) << (k % 64));
+            LimbArithmetic_addInto(R.data(), L, &One, 1);
+        } else if (Full) {
+            std::fill(R.begin(), R.end(), 0);
+        }
+    }
+}
+
+//
+// Single limb divisor, Möller and Granlund, "Improved division by invariant
+// integers", with the divisor normalized so its top bit is set
+//
+
+/// (U1:U0) / D, U1 < D, with Inverse = floor((2^128 - 1) / D) - 2^64
+static inline uint64_t divideStep(uint64_t U1, uint64_t U0, uint64_t D, uint64_t Inverse, uint64_t *Rem) {
+    // (Q1:Q0) = Inverse U1 + (U1:U0)
+    uint64_t Q1;
+    auto Q0 = LimbArithmetic_multiplyWide(Inverse, U1, &Q1);
+    Q0 += U0;
+    Q1 += U1 + (Q0 < U0) + 1;
+    auto R = U0 - Q1 * D;
+    if (R > Q0) {
+        Q1--;
+        R += D;
+    }
+    if (R >= D) {
+        Q1++;
+        R -= D;
+    }
+    *Rem = R;
+    return Q1;
+}
+
+static void divideSingleLimb(Limbs &Q, Limbs &R, const uint64_t *A, size_t ACount, uint64_t D) {
+    auto Shift = llvm::countLeadingZeros(D);
+    auto Norm = D << Shift;
+    uint64_t Unused;
+    auto Inverse = LimbArithmetic_divideWide(~Norm, ~UINT64_C(0), Norm, &Unused);
+
+    Q.assign(ACount, 0);
+    // the bits shifted out of the top limb start off the remainder
+    uint64_t Rem = Shift == 0 ? 0 : A[ACount - 1] >> (64 - Shift);
+    for (auto i = ACount; i-- > 0;) {
+        auto U0 = A[i] << Shift;
+        if (Shift != 0 && i > 0) {
+            U0 |= A[i - 1] >> (64 - Shift);
+        }
+        Q[i] = divideStep(Rem, U0, Norm, Inverse, &Rem);
+    }
+    R.assign(1, Rem >> Shift);
+}
+
+//
+// Newton reciprocal
+// For B normalized to n limbs, X is about 2^(128n) / B, with n + 1 limbs.
+// The reciprocal of the top half of B is refined by one Newton step
+// X' = X + X * (2^(128n) - B * X) / 2^(128n), doubling its precision.
+//
+
+static Limbs reciprocal(const uint64_t *B, size_t n) {
+    if (n <= RECIPROCAL_BASE_LIMBS) {
+        auto Width = static_cast<unsigned int>(128 * n + 64);
+        auto Num = llvm::APInt::getOneBitSet(Width, static_cast<unsigned int>(128 * n));
+        llvm::APInt Den(Width, llvm::ArrayRef<uint64_t>(B, n));
+        auto X = Num.udiv(Den);
+        return Limbs(X.getRawData(), X.getRawData() + n + 1);
+    }
+
+    // one limb more than half, so the error left by the step is below one
+    auto h = n / 2 + 1;
+    auto Low = n - h;
+    auto Xh = reciprocal(B + Low, h);
+
+    // B * X0 with X0 = Xh << 64 * Low
+    auto P = multiply(B, n, Xh.data(), h + 1);
+    P.insert(P.begin(), Low, 0);
+    P.resize(2 * n + 2, 0);
+    Limbs T(2 * n + 2, 0);
+    T[2 * n] = 1;
+
+    auto Negative = compare(P, T) > 0;
+    if (Negative) {
+        LimbArithmetic_subtractFrom(P.data(), P.size(), T.data(), T.size());
+    } else {
+        LimbArithmetic_subtractFrom(T.data(), T.size(), P.data(), P.size());
+        P.swap(T);
+    }
+    trim(P);
+
+    // X0 * E / 2^(128n), with X0 = Xh << 64 * Low
+    auto Correction = multiply(Xh.data(), h + 1, P.data(), P.size());
+    auto Drop = 2 * n - Low;
+    Limbs X(n + 1, 0);
+    std::copy(Xh.begin(), Xh.end(), X.begin() + Low);
+    if (Correction.size() > Drop) {
+        auto Count = std::min(Correction.size() - Drop, n + 1);
+        if (Negative) {
+            LimbArithmetic_subtractFrom(X.data(), n + 1, Correction.data() + Drop, Count);
+        } else {
+            LimbArithmetic_addInto(X.data(), n + 1, Correction.data() + Drop, Count);
+        }
+    }
+    return X;
+}
+
+/// U / B and U % B for U of 2n limbs, U < B * 2^(64n), B normalized
+/// The estimate from the top of U and the reciprocal is off by only a few,
+/// and is corrected against the true remainder
+static void divideChunk(Limbs &Q, Limbs &R, const Limbs &U, const Limbs &B, const Limbs &X) {
+    auto n = B.size();
+    auto Estimate = multiply(U.data() + n - 1, n + 1, X.data(), n + 1);
+    Q.assign(Estimate.begin() + n + 1, Estimate.end());
+
+    auto QB = multiply(Q.data(), Q.size(), B.data(), n);
+    R = U;
+    R.resize(std::max(R.size(), QB.size()), 0);
+    QB.resize(R.size(), 0);
+    const uint64_t One = 1;
+    while (compare(QB, R) > 0) {
+        LimbArithmetic_subtractFrom(Q.data(), Q.size(), &One, 1);
+        LimbArithmetic_subtractFrom(QB.data(), QB.size(), B.data(), n);
+    }
+    LimbArithmetic_subtractFrom(R.data(), R.size(), QB.data(), QB.size());
+    while (compare(R, B) >= 0) {
+        LimbArithmetic_addInto(Q.data(), Q.size(), &One, 1);
+        LimbArithmetic_subtractFrom(R.data(), R.size(), B.data(), n);
+    }
+    R.resize(n);
+}
+
+static void divideNewton(Limbs &Q, Limbs &R, const uint64_t *A, size_t ACount, const uint64_t *B, size_t n) {
+    auto Shift = llvm::countLeadingZeros(B[n - 1]);
+    auto BNorm = shiftLeftSmall(B, n, Shift);
+    BNorm.resize(n);
+    auto ANorm = shiftLeftSmall(A, ACount, Shift);
+    auto X = reciprocal(BNorm.data(), n);
+
+    // long division in base 2^(64n)
+    auto Chunks = (ANorm.size() + n - 1) / n;
+    ANorm.resize(Chunks * n, 0);
+    Q.assign(Chunks * n, 0);
+    Limbs Rem(n, 0);
+    Limbs U(2 * n);
+    Limbs ChunkQ;
+    for (auto c = Chunks; c-- > 0;) {
+        std::copy(ANorm.begin() + c * n, ANorm.begin() + (c + 1) * n, U.begin());
+        std::copy(Rem.begin(), Rem.end(), U.begin() + n);
+        divideChunk(ChunkQ, Rem, U, BNorm, X);
+        assert(LimbArithmetic_activeLimbs(ChunkQ.data(), ChunkQ.size()) <= n && "Quotient digit is too large");
+        std::copy(ChunkQ.begin(), ChunkQ.begin() + std::min(n, ChunkQ.size()), Q.begin() + c * n);
+    }
+
+    R.assign(n, 0);
+    extractBits(Rem.data(), n, Shift, 64 * n - Shift, R.data());
+}
+
+static void divideLong(Limbs &Q, Limbs &R, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    auto Width = static_cast<unsigned int>(64 * ACount);
+    llvm::APInt AVal(Width, llvm::ArrayRef<uint64_t>(A, ACount));
+    llvm::APInt BVal(Width, llvm::ArrayRef<uint64_t>(B, BCount));
+    llvm::APInt Quotient, Remainder;
+    llvm::APInt::udivrem(AVal, BVal, Quotient, Remainder);
+    Q.assign(Quotient.getRawData(), Quotient.getRawData() + ACount);
+    R.assign(Remainder.getRawData(), Remainder.getRawData() + ACount);
+}
+
+void LimbDivide_divideRemainder(uint64_t *Quotient, size_t QuotientCount, uint64_t *Remainder, size_t RemainderCount,
+                                const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    ACount = LimbArithmetic_activeLimbs(A, ACount);
+    BCount = LimbArithmetic_activeLimbs(B, BCount);
+    assert(BCount > 0 && "Divide by zero?");
+
+    Limbs Q;
+    Limbs R;
+    auto BBits = 64 * BCount - llvm::countLeadingZeros(B[BCount - 1]);
+    if (LimbArithmetic_compare(A, ACount, B, BCount) < 0) {
+        R.assign(A, A + ACount);
+    } else if (llvm::countPopulation(B[BCount - 1]) == 1 && LimbArithmetic_activeLimbs(B, BCount - 1) == 0) {
+        // 2^k: a shift and a mask
+        auto k = BBits - 1;
+        Q.assign(ACount, 0);
+        extractBits(A, ACount, k, 64 * ACount - k, Q.data());
+        R.assign(numLimbs(k + 1), 0);
+        extractBits(A, ACount, 0, k, R.data());
+    } else if (BCount == 1) {
+        divideSingleLimb(Q, R, A, ACount, B[0]);
+    } else if (isAllOnes(B, BCount, BBits)) {
+        divideAllOnes(Q, R, A, ACount, BBits);
+    } else if (BCount >= NEWTON_THRESHOLD) {
+        divideNewton(Q, R, A, ACount, B, BCount);
+    } else {
+        divideLong(Q, R, A, ACount, B, BCount);
+    }
+
+    store(Quotient, QuotientCount, Q);
+    store(Remainder, RemainderCount, R);
+}
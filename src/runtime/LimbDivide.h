@@ -0,0 +1,28 @@
+//===------ LimbDivide.h - Division of limb arrays ------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef> // for size_t
+#include <cstdint>
+
+//
+// Division of unsigned integers stored as arrays of 64-bit limbs, least
+// significant first, used by FiniteWord for wide words.
+//
+// Divisors that are powers of two become shifts, divisors of the form 2^k - 1
+// a folded add of k-bit digits, and single limb divisors a loop with a
+// precomputed reciprocal. Large divisors use a Newton iteration reciprocal
+// and Barrett-style quotient estimates built on LimbMultiply.
+//
+
+/// A / B into Quotient and A % B into Remainder, either of which may be null
+/// B is not 0, and the arrays are large enough for the results
+void LimbDivide_divideRemainder(uint64_t *Quotient, size_t QuotientCount, uint64_t *Remainder, size_t RemainderCount,
+                                const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount);
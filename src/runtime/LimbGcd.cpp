@@ -0,0 +1,299 @@
+//===------ LimbGcd.cpp ---------------------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "LimbGcd.h"
+
+#include "LimbAllocator.h"
+#include "LimbArithmetic.h"
+
+#include "../common/TuppenceMath.h"
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+#include <vector>
+
+/// Once the smaller operand is down to this many limbs, binary GCD finishes
+static const size_t BINARY_GCD_THRESHOLD = 2;
+
+typedef LimbVector Limbs;
+
+static void trim(Limbs &A) {
+    A.resize(LimbArithmetic_activeLimbs(A.data(), A.size()));
+}
+
+static int compare(const Limbs &A, const Limbs &B) {
+    return LimbArithmetic_compare(A.data(), A.size(), B.data(), B.size());
+}
+
+/// A is trimmed
+static size_t bitLength(const Limbs &A) {
+    return A.empty() ? 0 : A.size() * 64 - llvm::countLeadingZeros(A.back());
+}
+
+/// A is not 0
+static size_t trailingZeros(const Limbs &A) {
+    size_t i = 0;
+    while (A[i] == 0) {
+        i++;
+    }
+    return i * 64 + llvm::countTrailingZeros(A[i]);
+}
+
+static void shiftRight(Limbs &A, size_t Shift) {
+    auto LimbShift = Shift / 64;
+    auto BitShift = Shift % 64;
+    if (LimbShift >= A.size()) {
+        A.clear();
+        return;
+    }
+    auto Count = A.size() - LimbShift;
+    for (size_t i = 0; i < Count; i++) {
+        auto Bits = A[i + LimbShift] >> BitShift;
+        if (BitShift != 0 && i + LimbShift + 1 < A.size()) {
+            Bits |= A[i + LimbShift + 1] << (64 - BitShift);
+        }
+        A[i] = Bits;
+    }
+    A.resize(Count);
+    trim(A);
+}
+
+static void shiftLeft(Limbs &A, size_t Shift) {
+    if (A.empty() || Shift == 0) {
+        return;
+    }
+    auto LimbShift = Shift / 64;
+    auto BitShift = Shift % 64;
+    A.insert(A.begin(), LimbShift, 0);
+    if (BitShift != 0) {
+        A.push_back(0);
+        for (auto i = A.size(); i-- > LimbShift + 1;) {
+            A[i] = (A[i] << BitShift) | (A[i - 1] >> (64 - BitShift));
+        }
+        A[LimbShift] <<= BitShift;
+        trim(A);
+    }
+}
+
+/// (U, V) <- (V, U mod V), V is not 0
+static void remainderStep(Limbs &U, Limbs &V) {
+    auto Bits = static_cast<unsigned int>(U.size() * 64);
+    llvm::APInt UVal(Bits, static_cast<unsigned int>(U.size()), U.data());
+    llvm::APInt VVal(Bits, static_cast<unsigned int>(V.size()), V.data());
+    auto Rem = UVal.urem(VVal);
+    U.swap(V);
+    V.assign(Rem.getRawData(), Rem.getRawData() + Rem.getNumWords());
+    trim(V);
+}
+
+/// gcd(U, V) into U
+static void binaryGcd(Limbs &U, Limbs &V) {
+    if (U.empty()) {
+        U.swap(V);
+        return;
+    }
+    if (V.empty()) {
+        return;
+    }
+    auto Common = std::min(trailingZeros(U), trailingZeros(V));
+    shiftRight(U, trailingZeros(U));
+    // U is odd from here on
+    while (!V.empty()) {
+        if (U.size() == 1 && V.size() == 1) {
+            U[0] = Math_gcd(U[0], V[0]);
+            break;
+        }
+        shiftRight(V, trailingZeros(V));
+        if (compare(U, V) > 0) {
+            U.swap(V);
+        }
+        LimbArithmetic_subtractFrom(V.data(), V.size(), U.data(), U.size());
+        trim(V);
+    }
+    shiftLeft(U, Common);
+}
+
+//
+// Lehmer steps, on a window of the leading bits held in two limbs
+//
+
+/// Signed two-limb integer, two's complement, arithmetic wraps modulo 2^128
+struct Wide {
+    uint64_t Lo;
+    uint64_t Hi;
+};
+
+static Wide wideOf(int64_t A) {
+    return Wide{ static_cast<uint64_t>(A), A < 0 ? ~UINT64_C(0) : 0 };
+}
+
+static Wide wideAdd(Wide A, Wide B) {
+    auto Lo = A.Lo + B.Lo;
+    return Wide{ Lo, A.Hi + B.Hi + (Lo < A.Lo) };
+}
+
+static Wide wideSubtract(Wide A, Wide B) {
+    return Wide{ A.Lo - B.Lo, A.Hi - B.Hi - (A.Lo < B.Lo) };
+}
+
+static Wide wideMultiply(Wide A, uint64_t B) {
+    Wide Product;
+    Product.Lo = LimbArithmetic_multiplyWide(A.Lo, B, &Product.Hi);
+    Product.Hi += A.Hi * B;
+    return Product;
+}
+
+static bool widePositive(Wide A) {
+    return static_cast<int64_t>(A.Hi) > 0 || (A.Hi == 0 && A.Lo != 0);
+}
+
+static bool wideLess(Wide A, Wide B) {
+    return A.Hi != B.Hi ? A.Hi < B.Hi : A.Lo < B.Lo;
+}
+
+/// Unsigned N / D, D is not 0
+/// Returns ~0 if the quotient does not fit in a limb
+static uint64_t wideDivide(Wide N, Wide D) {
+    uint64_t Remainder;
+    if (D.Hi == 0) {
+        if (N.Hi >= D.Lo) {
+            return ~UINT64_C(0);
+        }
+        return LimbArithmetic_divideWide(N.Hi, N.Lo, D.Lo, &Remainder);
+    }
+    // estimate from the leading limb of the normalized D, then correct
+    // (Hacker's Delight, 9-5)
+    auto Shift = llvm::countLeadingZeros(D.Hi);
+    auto DTop = Shift == 0 ? D.Hi : (D.Hi << Shift) | (D.Lo >> (64 - Shift));
+    auto Q = LimbArithmetic_divideWide(N.Hi >> 1, (N.Hi << 63) | (N.Lo >> 1), DTop, &Remainder);
+    Q >>= 63 - Shift;
+    if (Q != 0) {
+        Q--;
+    }
+    if (!wideLess(wideSubtract(N, wideMultiply(D, Q)), D)) {
+        Q++;
+    }
+    return Q;
+}
+
+/// Leading bits of U used to guess quotients, small enough that the guesses
+/// and cofactor sums stay in a signed two-limb integer
+static const size_t LEHMER_BITS = 124;
+
+/// Cofactors stay below this, so applying them to a limb cannot overflow
+static const int64_t COFACTOR_LIMIT = INT64_C(1) << 62;
+
+/// LEHMER_BITS bits of A starting at bit Shift
+static Wide leadingBits(const Limbs &A, size_t Shift) {
+    auto Index = Shift / 64;
+    auto BitShift = Shift % 64;
+    auto Limb = [&A](size_t i) { return i < A.size() ? A[i] : 0; };
+    Wide Bits{ Limb(Index), Limb(Index + 1) };
+    if (BitShift != 0) {
+        Bits.Lo = (Bits.Lo >> BitShift) | (Bits.Hi << (64 - BitShift));
+        Bits.Hi = (Bits.Hi >> BitShift) | (Limb(Index + 2) << (64 - BitShift));
+    }
+    Bits.Hi &= (UINT64_C(1) << (LEHMER_BITS - 64)) - 1;
+    return Bits;
+}
+
+/// A - Q C into Result
+/// Returns false if that is not within COFACTOR_LIMIT
+static bool nextCofactor(int64_t A, uint64_t Q, int64_t C, int64_t *Result) {
+    auto Next = wideSubtract(wideOf(A), wideMultiply(wideOf(C), Q));
+    auto Low = static_cast<int64_t>(Next.Lo);
+    if ((Next.Hi == 0 && Low >= 0 && Low < COFACTOR_LIMIT) || (Next.Hi == ~UINT64_C(0) && Low < 0 && Low > -COFACTOR_LIMIT)) {
+        *Result = Low;
+        return true;
+    }
+    return false;
+}
+
+/// Replace (U, V) by a later pair of the remainder sequence, using quotients
+/// found from the leading two limbs (Knuth's Algorithm L)
+/// Returns false if not even one quotient could be found that way
+static bool lehmerStep(Limbs &U, Limbs &V) {
+    auto Shift = bitLength(U) - LEHMER_BITS;
+    auto X = leadingBits(U, Shift);
+    auto Y = leadingBits(V, Shift);
+    int64_t A = 1, B = 0, C = 0, D = 1;
+    while (true) {
+        auto YC = wideAdd(Y, wideOf(C));
+        auto YD = wideAdd(Y, wideOf(D));
+        if (!widePositive(YC) || !widePositive(YD)) {
+            break;
+        }
+        auto Q = wideDivide(wideAdd(X, wideOf(A)), YC);
+        if (Q != wideDivide(wideAdd(X, wideOf(B)), YD) || Q >= static_cast<uint64_t>(COFACTOR_LIMIT)) {
+            break;
+        }
+        int64_t NewC, NewD;
+        if (!nextCofactor(A, Q, C, &NewC) || !nextCofactor(B, Q, D, &NewD)) {
+            break;
+        }
+        A = C;
+        C = NewC;
+        B = D;
+        D = NewD;
+        auto NewY = wideSubtract(X, wideMultiply(Y, Q));
+        X = Y;
+        Y = NewY;
+    }
+    if (B == 0) {
+        return false;
+    }
+
+    // (U, V) <- (A U + B V, C U + D V)
+    Limbs NewU(U.size());
+    Limbs NewV(U.size());
+    auto CarryU = wideOf(0);
+    auto CarryV = wideOf(0);
+    for (size_t i = 0; i < U.size(); i++) {
+        auto UI = U[i];
+        auto VI = i < V.size() ? V[i] : 0;
+        CarryU = wideAdd(CarryU, wideAdd(wideMultiply(wideOf(A), UI), wideMultiply(wideOf(B), VI)));
+        CarryV = wideAdd(CarryV, wideAdd(wideMultiply(wideOf(C), UI), wideMultiply(wideOf(D), VI)));
+        NewU[i] = CarryU.Lo;
+        NewV[i] = CarryV.Lo;
+        CarryU = wideOf(static_cast<int64_t>(CarryU.Hi));
+        CarryV = wideOf(static_cast<int64_t>(CarryV.Hi));
+    }
+    assert(CarryU.Lo == 0 && CarryU.Hi == 0 && CarryV.Lo == 0 && CarryV.Hi == 0 && "Lehmer cofactors gave a negative remainder");
+    trim(NewU);
+    trim(NewV);
+    U.swap(NewU);
+    V.swap(NewV);
+    return true;
+}
+
+void LimbGcd_gcd(uint64_t *Dest, size_t DestCount, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    Limbs U(A, A + LimbArithmetic_activeLimbs(A, ACount));
+    Limbs V(B, B + LimbArithmetic_activeLimbs(B, BCount));
+    if (compare(U, V) < 0) {
+        U.swap(V);
+    }
+
+    while (V.size() > BINARY_GCD_THRESHOLD) {
+        if (lehmerStep(U, V)) {
+            continue;
+        }
+        // the leading limbs were not enough, e.g. when U is much larger than V
+        remainderStep(U, V);
+    }
+    if (!V.empty() && U.size() > BINARY_GCD_THRESHOLD) {
+        remainderStep(U, V);
+    }
+    binaryGcd(U, V);
+
+    assert(U.size() <= DestCount && "Dest is too small");
+    std::copy(U.begin(), U.end(), Dest);
+    std::fill(Dest + U.size(), Dest + DestCount, 0);
+}
@@ -0,0 +1,25 @@
+//===------ LimbGcd.h - Greatest common divisor of limb arrays ------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef> // for size_t
+#include <cstdint>
+
+//
+// Greatest common divisor of unsigned integers stored as arrays of 64-bit
+// limbs, least significant first, used by FiniteWord for wide words.
+//
+// Binary GCD for operands of a few limbs, Lehmer's algorithm driven by the
+// leading two limbs for larger ones.
+//
+
+/// gcd(A, B) into Dest, which has room for the larger of A and B
+/// gcd(A, 0) is A
+void LimbGcd_gcd(uint64_t *Dest, size_t DestCount, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount);
@@ -0,0 +1,441 @@
+//===------ LimbMultiply.cpp ----------------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "LimbMultiply.h"
+
+#include "LimbAllocator.h"
+#include "LimbArithmetic.h"
+
+#include "llvm/ADT/APInt.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+/// Thresholds are in limbs of the smaller operand
+static const size_t KARATSUBA_THRESHOLD = 32;
+static const size_t TOOM3_THRESHOLD = 160;
+static const size_t NTT_THRESHOLD = 4096;
+
+typedef LimbVector Limbs;
+
+static void multiplyFull(uint64_t *Dest, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount);
+
+//
+// Schoolbook
+//
+
+static void multiplySchoolbook(uint64_t *Dest, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    std::fill(Dest, Dest + ACount + BCount, 0);
+    for (size_t j = 0; j < BCount; j++) {
+        // writes Dest[j + ACount], which no earlier row has touched
+        llvm::APInt::tcMultiplyPart(Dest + j, A, B[j], 0, static_cast<unsigned int>(ACount), static_cast<unsigned int>(ACount + 1), true);
+    }
+}
+
+//
+// Karatsuba, ACount < 2 * BCount
+//
+
+static void multiplyKaratsuba(uint64_t *Dest, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    auto m = (ACount + 1) / 2;
+    assert(m <= BCount && "Operands are too unbalanced for Karatsuba");
+    auto A1Count = ACount - m;
+    auto B1Count = BCount - m;
+    auto Count = ACount + BCount;
+
+    // z0 and z2 go straight into the low and high parts of Dest
+    multiplyFull(Dest, A, m, B, m);
+    multiplyFull(Dest + 2 * m, A + m, A1Count, B + m, B1Count);
+
+    Limbs SumA(A, A + m);
+    SumA.push_back(0);
+    LimbArithmetic_addInto(SumA.data(), m + 1, A + m, A1Count);
+    Limbs SumB(B, B + m);
+    SumB.push_back(0);
+    LimbArithmetic_addInto(SumB.data(), m + 1, B + m, B1Count);
+
+    // z1 = (A0 + A1)(B0 + B1) - z0 - z2
+    Limbs Middle(2 * m + 2);
+    multiplyFull(Middle.data(), SumA.data(), m + 1, SumB.data(), m + 1);
+    LimbArithmetic_subtractFrom(Middle.data(), Middle.size(), Dest, 2 * m);
+    LimbArithmetic_subtractFrom(Middle.data(), Middle.size(), Dest + 2 * m, Count - 2 * m);
+
+    LimbArithmetic_addInto(Dest + m, Count - m, Middle.data(), LimbArithmetic_activeLimbs(Middle.data(), Middle.size()));
+}
+
+//
+// Toom-3, evaluating at 0, 1, -1, -2, and infinity
+//
+
+/// A magnitude with a sign, for the Toom-3 evaluation and interpolation
+struct SignedLimbs {
+    Limbs Magnitude;
+    bool Negative;
+
+    SignedLimbs() : Negative(false) {}
+
+    SignedLimbs(const uint64_t *A, size_t Count) :
+        Magnitude(A, A + LimbArithmetic_activeLimbs(A, Count)),
+        Negative(false) {}
+};
+
+static int compareMagnitude(const Limbs &A, const Limbs &B) {
+    return LimbArithmetic_compare(A.data(), A.size(), B.data(), B.size());
+}
+
+static void trim(Limbs &A) {
+    A.resize(LimbArithmetic_activeLimbs(A.data(), A.size()));
+}
+
+static SignedLimbs signedAdd(const SignedLimbs &A, const SignedLimbs &B) {
+    SignedLimbs Result;
+    if (A.Negative == B.Negative) {
+        auto &Long = A.Magnitude.size() >= B.Magnitude.size() ? A : B;
+        auto &Short = A.Magnitude.size() >= B.Magnitude.size() ? B : A;
+        Result.Magnitude = Long.Magnitude;
+        Result.Magnitude.push_back(0);
+        LimbArithmetic_addInto(Result.Magnitude.data(), Result.Magnitude.size(), Short.Magnitude.data(), Short.Magnitude.size());
+        Result.Negative = A.Negative;
+    } else {
+        auto Compare = compareMagnitude(A.Magnitude, B.Magnitude);
+        auto &Large = Compare >= 0 ? A : B;
+        auto &Small = Compare >= 0 ? B : A;
+        Result.Magnitude = Large.Magnitude;
+        LimbArithmetic_subtractFrom(Result.Magnitude.data(), Result.Magnitude.size(), Small.Magnitude.data(), Small.Magnitude.size());
+        Result.Negative = Large.Negative;
+    }
+    trim(Result.Magnitude);
+    if (Result.Magnitude.empty()) {
+        Result.Negative = false;
+    }
+    return Result;
+}
+
+static SignedLimbs signedSubtract(const SignedLimbs &A, const SignedLimbs &B) {
+    auto NegatedB = B;
+    NegatedB.Negative = !B.Negative && !B.Magnitude.empty();
+    return signedAdd(A, NegatedB);
+}
+
+static SignedLimbs signedMultiply(const SignedLimbs &A, const SignedLimbs &B) {
+    SignedLimbs Result;
+    if (A.Magnitude.empty() || B.Magnitude.empty()) {
+        return Result;
+    }
+    Result.Magnitude.resize(A.Magnitude.size() + B.Magnitude.size());
+    multiplyFull(Result.Magnitude.data(), A.Magnitude.data(), A.Magnitude.size(), B.Magnitude.data(), B.Magnitude.size());
+    trim(Result.Magnitude);
+    Result.Negative = A.Negative != B.Negative;
+    return Result;
+}
+
+/// A * 2
+static SignedLimbs signedDouble(const SignedLimbs &A) {
+    auto Result = A;
+    uint64_t Carry = 0;
+    for (auto &Limb : Result.Magnitude) {
+        auto Next = Limb >> 63;
+        Limb = (Limb << 1) | Carry;
+        Carry = Next;
+    }
+    if (Carry != 0) {
+        Result.Magnitude.push_back(Carry);
+    }
+    return Result;
+}
+
+/// A / Divisor, which must be exact, Divisor < 2^32
+static SignedLimbs signedDivideExact(const SignedLimbs &A, uint64_t Divisor) {
+    auto Result = A;
+    uint64_t Rem = 0;
+    for (auto i = Result.Magnitude.size(); i-- > 0;) {
+        auto Limb = Result.Magnitude[i];
+        auto Hi = (Rem << 32) | (Limb >> 32);
+        Rem = Hi % Divisor;
+        auto Lo = (Rem << 32) | (Limb & 0xffffffff);
+        Rem = Lo % Divisor;
+        Result.Magnitude[i] = ((Hi / Divisor) << 32) | (Lo / Divisor);
+    }
+    assert(Rem == 0 && "Division is not exact");
+    trim(Result.Magnitude);
+    return Result;
+}
+
+static void multiplyToom3(uint64_t *Dest, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    auto k = (ACount + 2) / 3;
+    auto Count = ACount + BCount;
+
+    // the three pieces of X, some of which may be empty when B is short
+    auto Piece = [k](const uint64_t *X, size_t XCount, size_t i) {
+        auto Lo = std::min(i * k, XCount);
+        auto Hi = std::min(i * k + k, XCount);
+        return SignedLimbs(X + Lo, Hi - Lo);
+    };
+
+    SignedLimbs Values[2][5];
+    const uint64_t *Operands[2] = {A, B};
+    size_t OperandCounts[2] = {ACount, BCount};
+    for (size_t o = 0; o < 2; o++) {
+        auto X0 = Piece(Operands[o], OperandCounts[o], 0);
+        auto X1 = Piece(Operands[o], OperandCounts[o], 1);
+        auto X2 = Piece(Operands[o], OperandCounts[o], 2);
+        auto Even = signedAdd(X0, X2);
+        auto &V = Values[o];
+        V[0] = X0;
+        V[1] = signedAdd(Even, X1);
+        V[2] = signedSubtract(Even, X1);
+        // X0 - 2 X1 + 4 X2 = 2 (V(-1) + X2) - X0
+        V[3] = signedSubtract(signedDouble(signedAdd(V[2], X2)), X0);
+        V[4] = X2;
+    }
+
+    SignedLimbs R[5];
+    for (size_t i = 0; i < 5; i++) {
+        R[i] = signedMultiply(Values[0][i], Values[1][i]);
+    }
+
+    // Bodrato's interpolation sequence
+    auto R0 = R[0];
+    auto R4 = R[4];
+    auto R3 = signedDivideExact(signedSubtract(R[3], R[1]), 3);
+    auto R1 = signedDivideExact(signedSubtract(R[1], R[2]), 2);
+    auto R2 = signedSubtract(R[2], R[0]);
+    R3 = signedAdd(signedDivideExact(signedSubtract(R2, R3), 2), signedDouble(R4));
+    R2 = signedSubtract(signedAdd(R2, R1), R4);
+    R1 = signedSubtract(R1, R3);
+
+    std::fill(Dest, Dest + Count, 0);
+    const SignedLimbs *Coefficients[5] = {&R0, &R1, &R2, &R3, &R4};
+    for (size_t i = 0; i < 5; i++) {
+        auto &C = *Coefficients[i];
+        if (C.Magnitude.empty()) {
+            continue;
+        }
+        assert(!C.Negative && "Negative coefficient");
+        LimbArithmetic_addInto(Dest + i * k, Count - i * k, C.Magnitude.data(), C.Magnitude.size());
+    }
+}
+
+//
+// Number-theoretic transform modulo 2^64 - 2^32 + 1, on 16-bit coefficients
+// A coefficient of the convolution is less than N * 2^32, so it is exact for
+// any transform length this prime supports (up to 2^32)
+//
+
+static const uint64_t NTT_PRIME = 0xffffffff00000001ULL;
+/// 2^64 mod NTT_PRIME
+static const uint64_t NTT_EPSILON = 0xffffffffULL;
+static const uint64_t NTT_GENERATOR = 7;
+static const size_t NTT_COEFFICIENT_BITS = 16;
+static const size_t NTT_COEFFICIENTS_PER_LIMB = 64 / NTT_COEFFICIENT_BITS;
+
+/// (Hi:Lo) mod NTT_PRIME
+static inline uint64_t nttReduce(uint64_t Hi, uint64_t Lo) {
+    auto HiHi = Hi >> 32;
+    auto HiLo = Hi & NTT_EPSILON;
+    // 2^96 = -1 and 2^64 = 2^32 - 1
+    auto T = Lo - HiHi;
+    if (Lo < HiHi) {
+        T -= NTT_EPSILON;
+    }
+    auto U = HiLo * NTT_EPSILON;
+    auto Sum = T + U;
+    if (Sum < U) {
+        Sum += NTT_EPSILON;
+    }
+    if (Sum >= NTT_PRIME) {
+        Sum -= NTT_PRIME;
+    }
+    return Sum;
+}
+
+static inline uint64_t nttMultiply(uint64_t A, uint64_t B) {
+    uint64_t Hi;
+    auto Lo = LimbArithmetic_multiplyWide(A, B, &Hi);
+    return nttReduce(Hi, Lo);
+}
+
+static inline uint64_t nttAdd(uint64_t A, uint64_t B) {
+    auto Sum = A + B;
+    if (Sum < A) {
+        Sum += NTT_EPSILON;
+    }
+    if (Sum >= NTT_PRIME) {
+        Sum -= NTT_PRIME;
+    }
+    return Sum;
+}
+
+static inline uint64_t nttSubtract(uint64_t A, uint64_t B) {
+    return A >= B ? A - B : A + (NTT_PRIME - B);
+}
+
+static uint64_t nttPower(uint64_t Base, uint64_t Exponent) {
+    uint64_t Result = 1;
+    while (Exponent != 0) {
+        if (Exponent & 1) {
+            Result = nttMultiply(Result, Base);
+        }
+        Base = nttMultiply(Base, Base);
+        Exponent >>= 1;
+    }
+    return Result;
+}
+
+static void nttTransform(Limbs &V, bool Inverse) {
+    auto N = V.size();
+    for (size_t i = 1, j = 0; i < N; i++) {
+        auto Bit = N >> 1;
+        for (; j & Bit; Bit >>= 1) {
+            j ^= Bit;
+        }
+        j ^= Bit;
+        if (i < j) {
+            std::swap(V[i], V[j]);
+        }
+    }
+    Limbs Twiddles;
+    for (size_t Length = 2; Length <= N; Length <<= 1) {
+        auto Root = nttPower(NTT_GENERATOR, (NTT_PRIME - 1) / Length);
+        if (Inverse) {
+            Root = nttPower(Root, NTT_PRIME - 2);
+        }
+        auto Half = Length / 2;
+        Twiddles.resize(Half);
+        Twiddles[0] = 1;
+        for (size_t j = 1; j < Half; j++) {
+            Twiddles[j] = nttMultiply(Twiddles[j - 1], Root);
+        }
+        for (size_t i = 0; i < N; i += Length) {
+            for (size_t j = 0; j < Half; j++) {
+                auto U = V[i + j];
+                auto W = nttMultiply(V[i + j + Half], Twiddles[j]);
+                V[i + j] = nttAdd(U, W);
+                V[i + j + Half] = nttSubtract(U, W);
+            }
+        }
+    }
+    if (Inverse) {
+        auto Scale = nttPower(N, NTT_PRIME - 2);
+        for (auto &X : V) {
+            X = nttMultiply(X, Scale);
+        }
+    }
+}
+
+static void splitCoefficients(Limbs &V, const uint64_t *A, size_t ACount) {
+    for (size_t i = 0; i < ACount * NTT_COEFFICIENTS_PER_LIMB; i++) {
+        V[i] = (A[i / NTT_COEFFICIENTS_PER_LIMB] >> (NTT_COEFFICIENT_BITS * (i % NTT_COEFFICIENTS_PER_LIMB))) & 0xffff;
+    }
+}
+
+static void multiplyNTT(uint64_t *Dest, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    auto Count = ACount + BCount;
+    size_t N = 1;
+    while (N < Count * NTT_COEFFICIENTS_PER_LIMB) {
+        N <<= 1;
+    }
+    assert(N <= ((size_t)1 << 32) && "Operands too large for the transform");
+
+    Limbs FA(N, 0);
+    splitCoefficients(FA, A, ACount);
+    nttTransform(FA, false);
+    if (A == B && ACount == BCount) {
+        // squaring, as for extended periods
+        for (size_t i = 0; i < N; i++) {
+            FA[i] = nttMultiply(FA[i], FA[i]);
+        }
+    } else {
+        Limbs FB(N, 0);
+        splitCoefficients(FB, B, BCount);
+        nttTransform(FB, false);
+        for (size_t i = 0; i < N; i++) {
+            FA[i] = nttMultiply(FA[i], FB[i]);
+        }
+    }
+    nttTransform(FA, true);
+
+    std::fill(Dest, Dest + Count, 0);
+    // the carry can outgrow a limb, so keep it as CarryHi:CarryLo
+    uint64_t CarryLo = 0;
+    uint64_t CarryHi = 0;
+    for (size_t i = 0; i < Count * NTT_COEFFICIENTS_PER_LIMB; i++) {
+        CarryLo += FA[i];
+        CarryHi += CarryLo < FA[i];
+        Dest[i / NTT_COEFFICIENTS_PER_LIMB] |= (CarryLo & 0xffff) << (NTT_COEFFICIENT_BITS * (i % NTT_COEFFICIENTS_PER_LIMB));
+        CarryLo = (CarryLo >> NTT_COEFFICIENT_BITS) | (CarryHi << (64 - NTT_COEFFICIENT_BITS));
+        CarryHi >>= NTT_COEFFICIENT_BITS;
+    }
+    assert(CarryLo == 0 && CarryHi == 0 && "Product overflowed");
+}
+
+//
+// Dispatch
+//
+
+/// Dest has ACount + BCount limbs and does not overlap A or B
+static void multiplyFull(uint64_t *Dest, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    if (ACount < BCount) {
+        std::swap(A, B);
+        std::swap(ACount, BCount);
+    }
+    if (BCount == 0) {
+        std::fill(Dest, Dest + ACount, 0);
+        return;
+    }
+    if (BCount < KARATSUBA_THRESHOLD) {
+        multiplySchoolbook(Dest, A, ACount, B, BCount);
+        return;
+    }
+    if (BCount >= NTT_THRESHOLD) {
+        multiplyNTT(Dest, A, ACount, B, BCount);
+        return;
+    }
+    if (ACount >= 2 * BCount) {
+        // multiply B by A in pieces of B's size
+        auto Count = ACount + BCount;
+        std::fill(Dest, Dest + Count, 0);
+        Limbs Partial(2 * BCount);
+        for (size_t Offset = 0; Offset < ACount; Offset += BCount) {
+            auto Chunk = std::min(BCount, ACount - Offset);
+            multiplyFull(Partial.data(), A + Offset, Chunk, B, BCount);
+            LimbArithmetic_addInto(Dest + Offset, Count - Offset, Partial.data(), Chunk + BCount);
+        }
+        return;
+    }
+    if (BCount < TOOM3_THRESHOLD) {
+        multiplyKaratsuba(Dest, A, ACount, B, BCount);
+        return;
+    }
+    multiplyToom3(Dest, A, ACount, B, BCount);
+}
+
+void LimbMultiply_multiply(uint64_t *Dest, size_t DestCount, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount) {
+    // limbs at or above DestCount cannot reach the low DestCount limbs
+    ACount = LimbArithmetic_activeLimbs(A, std::min(ACount, DestCount));
+    BCount = LimbArithmetic_activeLimbs(B, std::min(BCount, DestCount));
+
+    if (std::min(ACount, BCount) < KARATSUBA_THRESHOLD) {
+        // schoolbook, only computing the limbs that are kept
+        Limbs Product(DestCount, 0);
+        for (size_t j = 0; j < BCount && j < DestCount; j++) {
+            auto DestParts = std::min(ACount + 1, DestCount - j);
+            llvm::APInt::tcMultiplyPart(&Product[j], A, B[j], 0, static_cast<unsigned int>(ACount), static_cast<unsigned int>(DestParts), true);
+        }
+        std::copy(Product.begin(), Product.end(), Dest);
+        return;
+    }
+
+    Limbs Product(ACount + BCount);
+    multiplyFull(Product.data(), A, ACount, B, BCount);
+    auto Kept = std::min(DestCount, Product.size());
+    std::copy(Product.begin(), Product.begin() + Kept, Dest);
+    std::fill(Dest + Kept, Dest + DestCount, 0);
+}
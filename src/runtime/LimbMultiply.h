@@ -0,0 +1,25 @@
+//===------ LimbMultiply.h - Multiplication of limb arrays ----------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef> // for size_t
+#include <cstdint>
+
+//
+// Multiplication of unsigned integers stored as arrays of 64-bit limbs,
+// least significant first, used by FiniteWord for wide words.
+//
+// The algorithm is chosen by operand size: schoolbook, then Karatsuba, then
+// Toom-3, then a number-theoretic transform.
+//
+
+/// The low DestCount limbs of A * B
+/// Dest may be the same array as A or B
+void LimbMultiply_multiply(uint64_t *Dest, size_t DestCount, const uint64_t *A, size_t ACount, const uint64_t *B, size_t BCount);
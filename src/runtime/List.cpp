@@ -14,12 +14,14 @@
 
 // #include "tuppence/Logger.h"
 #include "../common/RationalWord.h"
+#include "../common/TuppenceMath.h"
 
 #include "llvm/Support/Casting.h"
 
 #include <sstream>
 #include <string>
 #include <cassert>
+#include <unordered_map>
 
 // namespace tuppence {
 
@@ -38,10 +40,14 @@
 struct List {
     TuppenceValue **Data;
     size_t Size;
+    
+    /// List_hash, or 0 before it is first asked for
+    uint64_t Hash;
 
     List(TuppenceValue **Data, size_t Size) :
         Data(Data),
-        Size(Size) {}
+        Size(Size),
+        Hash(0) {}
     
 //    bool operator==(List) const;
 //    bool operator!=(List) const;
@@ -235,6 +241,34 @@ FiniteWord *List_notEqual(List *list, List *other) {
     return FiniteWord_not(equal);
 }
 
+uint64_t List_hash(List *list) {
+    if (list->Hash != 0) {
+        return list->Hash;
+    }
+    uint64_t Hash = Math_mixHash(list->Size);
+    for (decltype(list->Size) i = 0; i < list->Size; i++) {
+        auto Val = list->Data[i];
+        uint64_t ValHash = 0;
+        if (Val->tag == FiniteWordTag) {
+            ValHash = FiniteWord_hash(Val->finite);
+        }
+        else if (Val->tag == RationalWordTag) {
+            ValHash = RationalWord_hash(Val->rational);
+        }
+        else if (Val->tag == ListTag) {
+            ValHash = List_hash(Val->list);
+        }
+        // mixing at each step makes the order count
+        Hash = Math_mixHash(Hash + ValHash + Val->tag);
+    }
+    // 0 means not yet computed
+    if (Hash == 0) {
+        Hash = 1;
+    }
+    list->Hash = Hash;
+    return Hash;
+}
+
 FiniteWord *List_arrayEqual(List **Vals, size_t count) {
     assert(count > 1 && "Vals does not contain more than one element");
     auto First = Vals[0];
@@ -249,12 +283,21 @@ FiniteWord *List_arrayEqual(List **Vals, size_t count) {
 
 FiniteWord *List_arrayNotEqual(List **Vals, size_t count) {
     assert(count > 1 && "Vals does not contain more than one element");
-    auto First = Vals[0];
-    for (decltype(count) i = 1; i < count; i++) {
-        // maintain intuitive order
-        if (List_equal(Vals[i], First)) {
-            return FiniteWord_ZERO_1BIT;
+    // every pair must differ, and only lists with the same hash are compared in full
+    std::unordered_multimap<uint64_t, List *> Seen;
+    Seen.reserve(count);
+    for (decltype(count) i = 0; i < count; i++) {
+        auto Second = Vals[i];
+        auto Hash = List_hash(Second);
+        auto Range = Seen.equal_range(Hash);
+        for (auto Iter = Range.first; Iter != Range.second; ++Iter) {
+            auto First = Iter->second;
+            // maintain intuitive order
+            if (FiniteWord_equal(List_equal(Second, First), FiniteWord_ONE_1BIT)) {
+                return FiniteWord_ZERO_1BIT;
+            }
         }
+        Seen.insert(std::make_pair(Hash, Second));
     }
     return FiniteWord_ONE_1BIT;
 }
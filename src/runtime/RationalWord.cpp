@@ -20,7 +20,9 @@
 
 #include <algorithm> // for std::find
 #include <cassert>
+#include <cmath>
 //#include <sstream>
+#include <unordered_map>
 #include <vector>
 
 
@@ -34,9 +36,13 @@ struct RationalWord {
     FiniteWord *period;
     FiniteWord *transient;
     
+    /// RationalWord_hash, or 0 before it is first asked for
+    uint64_t hash;
+    
     RationalWord(FiniteWord *period, FiniteWord *transient) :
     period(period),
-    transient(transient) {}
+    transient(transient),
+    hash(0) {}
     
     // bitwise operations
     //
@@ -227,7 +233,7 @@ void calculateFraction(RationalWord *word, RationalWord **Numerator, RationalWor
             *Denominator = RationalWord_createFromPeriodTransient(FiniteWord_ZERO_1BIT, wReduced);
             *Numerator = RationalWord_minus(RationalWord_createFromPeriodTransient(FiniteWord_ZERO_1BIT, xReduced));
         }
-        else if (word->period == FiniteWord_ONE_1BIT) {
+        else if (FiniteWord_equal(word->period, FiniteWord_ONE_1BIT)) {
             *Denominator = RationalWord_ONE;
             *Numerator = RationalWord_MINUS_ONE;
         }
@@ -329,37 +335,22 @@ uint64_t RationalWord_integerValue(RationalWord* word) {
 //    return Denominator;
 //}
 
+/// Move the part of the transient that already continues the period into the
+/// period, all at once
 void windupTransient(FiniteWord **period, FiniteWord **transient) {
-    
     auto periodSize = FiniteWord_size(*period);
     auto transientSize = FiniteWord_size(*transient);
     assert(periodSize > 0 && "Period size is 0");
-    while (1) {
-        periodSize = FiniteWord_size(*period);
-        transientSize = FiniteWord_size(*transient);
-        auto min = std::min(periodSize, transientSize);
-        auto common = 0;
-        for (decltype(min) i = 0; i < min; i++) {
-            auto periodBit = FiniteWord_getBit(*period, periodSize - 1 - i);
-            auto transientBit = FiniteWord_getBit(*transient, transientSize - 1 - i);
-            if (periodBit == transientBit) {
-                common++;
-            }
-            else {
-                break;
-            }
-        }
-
-        if (common == 0) {
-            break;
-        }
+    auto common = FiniteWord_commonTopRun(*period, *transient);
+    if (common == 0) {
+        return;
+    }
 
-        // rotate period to the left
-        *period = FiniteWord_rotateLeft(*period, common);
+    // rotate period to the left
+    *period = FiniteWord_rotateLeft(*period, common % periodSize);
 
-        //remove last bit of transient;
-        *transient = FiniteWord_residue(*transient, transientSize - common);
-    }
+    //remove last bits of transient;
+    *transient = FiniteWord_residue(*transient, transientSize - common);
 }
 
 void reduce(FiniteWord **period, FiniteWord **transient) {
@@ -406,16 +397,22 @@ void extendTransient(FiniteWord **period, FiniteWord **transient, size_t extent)
     *period = FiniteWord_rotateRight(*period, diff);
 }
 
-void alignPeriodAndTransient(FiniteWord **PeriodL, FiniteWord **TransientL,
-                            FiniteWord **PeriodR, FiniteWord **TransientR) {
-
-    // Extend transients to match
+// extend the shorter transient to the size of the other
+void alignTransients(FiniteWord **PeriodL, FiniteWord **TransientL,
+                     FiniteWord **PeriodR, FiniteWord **TransientR) {
     if (FiniteWord_size(*TransientL) > FiniteWord_size(*TransientR)) {
         extendTransient(PeriodR, TransientR, FiniteWord_size(*TransientL));
     }
     else if (FiniteWord_size(*TransientL) < FiniteWord_size(*TransientR)) {
         extendTransient(PeriodL, TransientL, FiniteWord_size(*TransientR));
     }
+}
+
+void alignPeriodAndTransient(FiniteWord **PeriodL, FiniteWord **TransientL,
+                            FiniteWord **PeriodR, FiniteWord **TransientR) {
+
+    // Extend transients to match
+    alignTransients(PeriodL, TransientL, PeriodR, TransientR);
 
     // Multiply Periods
     auto LCM = Math_lcm(FiniteWord_size(*PeriodL), FiniteWord_size(*PeriodR));
@@ -451,6 +448,19 @@ bool RationalWord_notEqual(RationalWord *A, RationalWord *B) {
     }
 }
 
+uint64_t RationalWord_hash(RationalWord *word) {
+    if (word->hash != 0) {
+        return word->hash;
+    }
+    auto hash = Math_mixHash(FiniteWord_hash(word->period) + Math_mixHash(FiniteWord_hash(word->transient)));
+    // 0 means not yet computed
+    if (hash == 0) {
+        hash = 1;
+    }
+    word->hash = hash;
+    return hash;
+}
+
 bool RationalWord_arrayEqual(RationalWord **ToTest, size_t Count) {
     assert(Count > 1 && "Vals does not contain more than one element");
     std::vector<RationalWord *> Vals(ToTest, ToTest + Count);
@@ -468,18 +478,21 @@ bool RationalWord_arrayEqual(RationalWord **ToTest, size_t Count) {
 
 bool RationalWord_arrayNotEqual(RationalWord **ToTest, size_t Count) {
     assert(Count > 1 && "Vals does not contain more than one element");
-    std::vector<RationalWord *> Vals(ToTest, ToTest + Count);
-    for (auto Iter = Vals.begin(); Iter != Vals.end(); ++Iter) {
-        auto First = *Iter;
-        auto Iter2 = Iter;
-        Iter2++;
-        for (; Iter2 != Vals.end(); Iter2++) {
-            auto Second = *Iter2;
+    // only words with the same hash are compared in full
+    std::unordered_multimap<uint64_t, RationalWord *> Seen;
+    Seen.reserve(Count);
+    for (size_t i = 0; i < Count; i++) {
+        auto Second = ToTest[i];
+        auto Hash = RationalWord_hash(Second);
+        auto Range = Seen.equal_range(Hash);
+        for (auto Iter = Range.first; Iter != Range.second; ++Iter) {
+            auto First = Iter->second;
             // maintain intuitive order
-            if (Second == First) {
+            if (RationalWord_equal(Second, First)) {
                 return false;
             }
         }
+        Seen.insert(std::make_pair(Hash, Second));
     }
     return true;
 }
@@ -536,9 +549,10 @@ RationalWord *RationalWord_or(RationalWord *A, RationalWord *B) {
     auto TransientA = A->transient;
     auto TransientB = B->transient;
 
-    alignPeriodAndTransient(&PeriodA, &TransientA, &PeriodB, &TransientB);
+    // the periods are combined without repeating them to a common size
+    alignTransients(&PeriodA, &TransientA, &PeriodB, &TransientB);
 
-    auto Period = FiniteWord_or(PeriodA, PeriodB);
+    auto Period = FiniteWord_periodOr(PeriodA, PeriodB);
     auto Transient = FiniteWord_or(TransientA, TransientB);
 
     return RationalWord_createFromPeriodTransient(Period, Transient);
@@ -550,9 +564,9 @@ RationalWord *RationalWord_and(RationalWord *A, RationalWord *B) {
     auto TransientA = A->transient;
     auto TransientB = B->transient;
     
-    alignPeriodAndTransient(&PeriodA, &TransientA, &PeriodB, &TransientB);
+    alignTransients(&PeriodA, &TransientA, &PeriodB, &TransientB);
     
-    auto Period = FiniteWord_and(PeriodA, PeriodB);
+    auto Period = FiniteWord_periodAnd(PeriodA, PeriodB);
     auto Transient = FiniteWord_and(TransientA, TransientB);
     
     return RationalWord_createFromPeriodTransient(Period, Transient);
@@ -560,13 +574,13 @@ RationalWord *RationalWord_and(RationalWord *A, RationalWord *B) {
 
 RationalWord *RationalWord_xor(RationalWord *A, RationalWord *B) {
     auto PeriodA = A->period;
-    auto PeriodB = A->period;
+    auto PeriodB = B->period;
     auto TransientA = A->transient;
-    auto TransientB = A->transient;
+    auto TransientB = B->transient;
     
-    alignPeriodAndTransient(&PeriodA, &TransientA, &PeriodB, &TransientB);
+    alignTransients(&PeriodA, &TransientA, &PeriodB, &TransientB);
     
-    auto Period = FiniteWord_xor(PeriodA, PeriodB);
+    auto Period = FiniteWord_periodXor(PeriodA, PeriodB);
     auto Transient = FiniteWord_xor(TransientA, TransientB);
     
     return RationalWord_createFromPeriodTransient(Period, Transient);
@@ -621,6 +635,155 @@ RationalWord *RationalWord_minus(RationalWord *word) {
     return RationalWord_plus(RationalWord_not(word), RationalWord_ONE);
 }
 
+//
+// Closed form of the periodic part of a sum
+//
+// A period P of size p repeated forever is the 2-adic number -P / (2^p - 1).
+// The sum of two of them and a carry c is c - U / V, with
+//     U = PA * (2^pB - 1) + PB * (2^pA - 1)
+//     V = (2^pA - 1) * (2^pB - 1)
+// Once gcd(U, V) is divided out, the sum repeats every q bits, where q is the
+// order of 2 modulo V. With K = (2^q - 1) / V, the period is U * K, taking
+// one 2^q - 1 out of it into c if it does not fit in q bits.
+//
+// All of this is arithmetic on words of about pA + pB bits, plus a division
+// and a multiply at q bits. The streamed sum instead walks the least common
+// multiple of pA and pB. The closed form wins when that is much longer than
+// the operands and the sum repeats well before it.
+//
+
+// Rough costs in nanoseconds, measured on x86-64, only compared with each other
+
+/// Per limb of the least common multiple, for streaming the sum
+static const double STREAM_COST_PER_LIMB = 100;
+
+/// Setting up U and V and finding the order grow with the limbs of pA + pB
+/// to about this power, mostly in the gcd
+static const double PREPARE_COST_EXPONENT = 1.46;
+static const double PREPARE_COST_FACTOR = 350;
+
+/// Per product of limbs of the quotient and divisor, for building the period
+static const double BUILD_COST_PER_PRODUCT = 24;
+
+static double limbsOf(size_t Bits) {
+    return static_cast<double>((Bits + 63) / 64);
+}
+
+/// Distinct prime factors of n
+static std::vector<size_t> primeFactors(size_t n) {
+    std::vector<size_t> Primes;
+    for (size_t Prime = 2; Prime * Prime <= n; Prime++) {
+        if (n % Prime != 0) {
+            continue;
+        }
+        Primes.push_back(Prime);
+        while (n % Prime == 0) {
+            n /= Prime;
+        }
+    }
+    if (n > 1) {
+        Primes.push_back(n);
+    }
+    return Primes;
+}
+
+/// p 1 bits, zero-extended to width
+static FiniteWord *allOnes(size_t p, size_t width) {
+    return FiniteWord_zext(FiniteWord_createFromRepsWord(p, FiniteWord_ONE_1BIT), width);
+}
+
+/// 2^Exponent mod Modulus, at twice the width of Modulus
+static FiniteWord *powerOfTwoMod(size_t Exponent, FiniteWord *Modulus) {
+    auto Width = 2 * FiniteWord_size(Modulus);
+    auto Wide = FiniteWord_zext(Modulus, Width);
+    auto Result = FiniteWord_urem(FiniteWord_createFromVal(Width, 1), Wide);
+    for (auto Bit = Math_bitLength(Exponent); Bit > 0; Bit--) {
+        Result = FiniteWord_urem(FiniteWord_multiply(Result, Result), Wide);
+        if ((Exponent >> (Bit - 1)) & 1) {
+            Result = FiniteWord_urem(FiniteWord_leftShift(Result, 1), Wide);
+        }
+    }
+    return Result;
+}
+
+bool RationalWord_closedFormPeriodPlus(FiniteWord *A, FiniteWord *B, uint8_t Carry, bool CheckCost, FiniteWord **Prefix, FiniteWord **Period) {
+    auto SizeA = FiniteWord_size(A);
+    auto SizeB = FiniteWord_size(B);
+    auto Common = Math_lcm(SizeA, SizeB);
+    if (CheckCost && Math_gcd(SizeA, SizeB) == 1) {
+        // the periods of rational words are as small as they can be, so with
+        // coprime sizes the sum repeats every Common bits and nothing is saved
+        return false;
+    }
+    
+    auto StreamCost = STREAM_COST_PER_LIMB * limbsOf(Common);
+    auto Width = SizeA + SizeB + 1;
+    auto PrepareCost = PREPARE_COST_FACTOR * std::pow(limbsOf(Width), PREPARE_COST_EXPONENT);
+    if (CheckCost && PrepareCost >= StreamCost) {
+        return false;
+    }
+    
+    auto OnesA = allOnes(SizeA, Width);
+    auto OnesB = allOnes(SizeB, Width);
+    auto V = FiniteWord_multiply(OnesA, OnesB);
+    auto U = FiniteWord_add(FiniteWord_multiply(FiniteWord_zext(A, Width), OnesB), FiniteWord_multiply(FiniteWord_zext(B, Width), OnesA));
+    auto G = FiniteWord_gcd(U, V);
+    
+    // U <= 2 * V, so both fit in one bit more than V
+    auto VBits = FiniteWord_getActiveBits(FiniteWord_udiv(V, G));
+    auto ReducedWidth = VBits + 1;
+    U = FiniteWord_residue(FiniteWord_udiv(U, G), ReducedWidth);
+    V = FiniteWord_residue(FiniteWord_udiv(V, G), ReducedWidth);
+    
+    // 1 mod V, which is 0 when V is 1
+    auto One = powerOfTwoMod(0, V);
+    size_t Order = Common;
+    for (auto Prime : primeFactors(Common)) {
+        while (Order % Prime == 0 && FiniteWord_equal(powerOfTwoMod(Order / Prime, V), One)) {
+            Order /= Prime;
+        }
+    }
+    
+    // V divides 2^Order - 1, building the period is a division of that by V
+    // and a multiply of the quotient by U
+    auto BuildCost = BUILD_COST_PER_PRODUCT * limbsOf(Order - VBits + 1) * limbsOf(ReducedWidth);
+    if (CheckCost && BuildCost >= StreamCost) {
+        return false;
+    }
+    
+    // U * K <= 2 * (2^Order - 1)
+    auto OrderWidth = std::max(Order, ReducedWidth) + 2;
+    auto Ones = allOnes(Order, OrderWidth);
+    auto K = FiniteWord_udiv(Ones, FiniteWord_zext(V, OrderWidth));
+    auto W = FiniteWord_multiply(FiniteWord_zext(U, OrderWidth), K);
+    int Adjust = Carry;
+    if (FiniteWord_ugt(W, Ones)) {
+        W = FiniteWord_subtract(W, Ones);
+        Adjust--;
+    }
+    W = FiniteWord_residue(W, Order);
+    
+    if (Adjust == 0) {
+        *Prefix = FiniteWord_EMPTY;
+        *Period = W;
+    } else if (Adjust > 0) {
+        FiniteWord_periodPlus(W, FiniteWord_ZERO_1BIT, 1, Prefix, Period);
+    } else {
+        // -1 is 1 repeated forever
+        FiniteWord_periodPlus(W, FiniteWord_ONE_1BIT, 0, Prefix, Period);
+    }
+    return true;
+}
+
+/// Sum of periods A and B, each repeated forever, plus Carry, by whichever of
+/// the closed form and the stream is expected to be cheaper
+static void periodPlus(FiniteWord *A, FiniteWord *B, uint8_t Carry, FiniteWord **Prefix, FiniteWord **Period) {
+    if (RationalWord_closedFormPeriodPlus(A, B, Carry, true, Prefix, Period)) {
+        return;
+    }
+    FiniteWord_periodPlus(A, B, Carry, Prefix, Period);
+}
+
 RationalWord *RationalWord_plus(RationalWord *word, RationalWord *other) {
 
     auto PeriodA = word->period;
@@ -628,7 +791,7 @@ RationalWord *RationalWord_plus(RationalWord *word, RationalWord *other) {
     auto TransientA = word->transient;
     auto TransientB = other->transient;
 
-    alignPeriodAndTransient(&PeriodA, &TransientA, &PeriodB, &TransientB);
+    alignTransients(&PeriodA, &TransientA, &PeriodB, &TransientB);
 
     FiniteWord *TransientOutput;
     FiniteWord *TransientCarry;
@@ -640,32 +803,12 @@ RationalWord *RationalWord_plus(RationalWord *word, RationalWord *other) {
     FiniteWord_arrayPlus(&TransientVals[0], 2, &TransientCarry, &TransientOutput);
     assert(FiniteWord_size(TransientCarry) == 1 && "Adding 2 FiniteWords did not give a Carry of size 1");
 
+    // the periods are added as streams, without repeating them to a common size
+    FiniteWord *Prefix;
     FiniteWord *PeriodOutput;
-    FiniteWord *PeriodCarry = FiniteWord_createFromFiniteWord(TransientCarry);
-    FiniteWord *PreviousPeriodCarry;
-    std::vector<FiniteWord *> PeriodVals;
-
-    FiniteWord *TransientAccumulate = FiniteWord_createFromFiniteWord(TransientOutput);
-
-    do {
-        PreviousPeriodCarry = PeriodCarry;
-
-        auto CarryExtended = FiniteWord_concatenate(FiniteWord_createFromRepsWord(FiniteWord_size(PeriodA) - 1, FiniteWord_ZERO_1BIT), PeriodCarry);
-
-        PeriodVals.clear();
-        // maintain intuitive order
-        PeriodVals.push_back(PeriodB);
-        PeriodVals.push_back(PeriodA);
-        PeriodVals.push_back(CarryExtended);
-        FiniteWord_arrayPlus(&PeriodVals[0], 3, &PeriodCarry, &PeriodOutput);
-        assert(FiniteWord_size(PeriodCarry) == 2 && "Adding 3 FiniteWords did not give a Carry of size 2");
-        PeriodCarry = FiniteWord_residue(PeriodCarry, 1);
-
-        TransientAccumulate = FiniteWord_concatenate(PeriodOutput, TransientAccumulate);
+    periodPlus(PeriodA, PeriodB, FiniteWord_getBit(TransientCarry, 0), &Prefix, &PeriodOutput);
 
-    } while (FiniteWord_notEqual(PeriodCarry, PreviousPeriodCarry));
-
-    return RationalWord_createFromPeriodTransient(PeriodOutput, TransientAccumulate);
+    return RationalWord_createFromPeriodTransient(PeriodOutput, FiniteWord_concatenate(Prefix, TransientOutput));
 }
 
 RationalWord *RationalWord_subtract(RationalWord *word, RationalWord *other) {
@@ -674,50 +817,36 @@ RationalWord *RationalWord_subtract(RationalWord *word, RationalWord *other) {
     auto TransientA = word->transient;
     auto TransientB = FiniteWord_not(other->transient);
 
-    alignPeriodAndTransient(&PeriodA, &TransientA, &PeriodB, &TransientB);
+    alignTransients(&PeriodA, &TransientA, &PeriodB, &TransientB);
 
     FiniteWord *TransientOutput;
     FiniteWord *TransientBorrow;
 
-    auto BorrowExtended = FiniteWord_concatenate(FiniteWord_createFromRepsWord(FiniteWord_size(TransientA) - 1, FiniteWord_ZERO_1BIT), FiniteWord_ONE_1BIT);
-    std::vector<FiniteWord *> TransientVals;
-    TransientVals.push_back(BorrowExtended);
-    TransientVals.push_back(TransientB);
-    TransientVals.push_back(TransientA);
-    FiniteWord_arrayPlus(&TransientVals[0], 3, &TransientBorrow, &TransientOutput);
-    assert(FiniteWord_size(TransientBorrow) == 2 && "Adding 3 FiniteWords did not give a Carry of size 2");
-    TransientBorrow = FiniteWord_residue(TransientBorrow, 1);
+    if (FiniteWord_size(TransientA) == 0) {
+        // the 1 of the negation goes straight into the periods
+        TransientOutput = FiniteWord_EMPTY;
+        TransientBorrow = FiniteWord_ONE_1BIT;
+    } else {
+        auto BorrowExtended = FiniteWord_concatenate(FiniteWord_createFromRepsWord(FiniteWord_size(TransientA) - 1, FiniteWord_ZERO_1BIT), FiniteWord_ONE_1BIT);
+        std::vector<FiniteWord *> TransientVals;
+        TransientVals.push_back(BorrowExtended);
+        TransientVals.push_back(TransientB);
+        TransientVals.push_back(TransientA);
+        FiniteWord_arrayPlus(&TransientVals[0], 3, &TransientBorrow, &TransientOutput);
+        assert(FiniteWord_size(TransientBorrow) == 2 && "Adding 3 FiniteWords did not give a Carry of size 2");
+        TransientBorrow = FiniteWord_residue(TransientBorrow, 1);
+    }
 
+    FiniteWord *Prefix;
     FiniteWord *PeriodOutput;
-    FiniteWord *PeriodBorrow = FiniteWord_createFromFiniteWord(TransientBorrow);
-    FiniteWord *PreviousPeriodBorrow;
-    std::vector<FiniteWord *> PeriodVals;
-
-    FiniteWord *TransientAccumulate = FiniteWord_createFromFiniteWord(TransientOutput);
-
-    do {
-        PreviousPeriodBorrow = PeriodBorrow;
-
-        auto BorrowExtended = FiniteWord_concatenate(FiniteWord_createFromRepsWord(FiniteWord_size(PeriodA) - 1, FiniteWord_ZERO_1BIT), PeriodBorrow);
-
-        PeriodVals.clear();
-        PeriodVals.push_back(PeriodA);
-        PeriodVals.push_back(PeriodB);
-        PeriodVals.push_back(BorrowExtended);
-        FiniteWord_arrayPlus(&PeriodVals[0], 3, &PeriodBorrow, &PeriodOutput);
-        assert(FiniteWord_size(PeriodBorrow) == 2 && "Adding 3 FiniteWords did not give a Carry of size 2");
-        PeriodBorrow = FiniteWord_residue(PeriodBorrow, 1);
-
-        TransientAccumulate = FiniteWord_concatenate(PeriodOutput, TransientAccumulate);
-
-    } while (FiniteWord_notEqual(PeriodBorrow, PreviousPeriodBorrow));
+    periodPlus(PeriodA, PeriodB, FiniteWord_getBit(TransientBorrow, 0), &Prefix, &PeriodOutput);
 
-    return RationalWord_createFromPeriodTransient(PeriodOutput, TransientAccumulate);
+    return RationalWord_createFromPeriodTransient(PeriodOutput, FiniteWord_concatenate(Prefix, TransientOutput));
 }
 
 RationalWord *finiteMultiply(RationalWord *A, FiniteWord *B) {
     auto BReversed = FiniteWord_reverse(B);
-    RationalWord *Accumulate;
+    auto Accumulate = RationalWord_ZERO;
     FiniteWord *Bit;
     while (FiniteWord_size(BReversed) > 0) {
         Accumulate = RationalWord_concatenate(Accumulate, FiniteWord_ZERO_1BIT);
@@ -753,12 +882,17 @@ RationalWord *RationalWord_times(RationalWord *word, RationalWord *other) {
 
         auto PeriodStart = std::find_if(PeriodPartials.begin(), PeriodPartials.end(), [Partial](RationalWord *x){ return RationalWord_equal(x, Partial); });
         if (PeriodStart != PeriodPartials.end()) {
+            auto TransientBuilder = FiniteWordBuilder_create();
+            FiniteWordBuilder_append(TransientBuilder, Transient);
             for (auto TransientIter = PeriodPartials.begin(); TransientIter < PeriodStart; TransientIter++) {
-                Transient = FiniteWord_concatenate(RationalWord_residue(*TransientIter, BPeriodSize), Transient);
+                FiniteWordBuilder_append(TransientBuilder, RationalWord_residue(*TransientIter, BPeriodSize));
             }
+            Transient = FiniteWordBuilder_finish(TransientBuilder);
+            auto PeriodBuilder = FiniteWordBuilder_create();
             for (auto PeriodIter = PeriodStart; PeriodIter < PeriodPartials.end(); PeriodIter++) {
-                Period = FiniteWord_concatenate(RationalWord_residue(*PeriodIter, BPeriodSize), Period);
+                FiniteWordBuilder_append(PeriodBuilder, RationalWord_residue(*PeriodIter, BPeriodSize));
             }
+            Period = FiniteWordBuilder_finish(PeriodBuilder);
 
             break;
         }
@@ -766,9 +900,12 @@ RationalWord *RationalWord_times(RationalWord *word, RationalWord *other) {
         PeriodPartials.push_back(Partial);
         if (BTransientSize + PeriodPartials.size() >= Tuppence_LOOP_LIMIT) {
             LogWarning(("Loop limit exceeded in RationalWord multiply. Returning truncated result. Loop limit is: " + std::to_string(Tuppence_LOOP_LIMIT)).c_str());
+            auto TransientBuilder = FiniteWordBuilder_create();
+            FiniteWordBuilder_append(TransientBuilder, Transient);
             for (auto TransientIter = PeriodPartials.begin(); TransientIter < PeriodPartials.end(); TransientIter++) {
-                Transient = FiniteWord_concatenate(RationalWord_residue(*TransientIter, 1), Transient);
+                FiniteWordBuilder_append(TransientBuilder, RationalWord_residue(*TransientIter, 1));
             }
+            Transient = FiniteWordBuilder_finish(TransientBuilder);
             return RationalWord_createFromPeriodTransient(FiniteWord_ZERO_1BIT, Transient);
         }
 
@@ -801,12 +938,18 @@ RationalWord *RationalWord_divide(RationalWord *word, RationalWord *other) {
         
         auto PeriodStart = std::find_if(Partials.begin(), Partials.end(), [Partial](RationalWord *x){ return RationalWord_equal(x, Partial); });
         if (PeriodStart != Partials.end()) {
+            auto TransientBuilder = FiniteWordBuilder_create();
+            FiniteWordBuilder_append(TransientBuilder, Transient);
             for (auto TransientIter = Partials.begin(); TransientIter < PeriodStart; TransientIter++) {
-                Transient = FiniteWord_concatenate(RationalWord_residue(*TransientIter, 1), Transient);
+                FiniteWordBuilder_append(TransientBuilder, RationalWord_residue(*TransientIter, 1));
             }
+            Transient = FiniteWordBuilder_finish(TransientBuilder);
+            auto PeriodBuilder = FiniteWordBuilder_create();
+            FiniteWordBuilder_append(PeriodBuilder, Period);
             for (auto PeriodIter = PeriodStart; PeriodIter < Partials.end(); PeriodIter++) {
-                Period = FiniteWord_concatenate(RationalWord_residue(*PeriodIter, 1), Period);
+                FiniteWordBuilder_append(PeriodBuilder, RationalWord_residue(*PeriodIter, 1));
             }
+            Period = FiniteWordBuilder_finish(PeriodBuilder);
 
             break;
         }
@@ -814,9 +957,12 @@ RationalWord *RationalWord_divide(RationalWord *word, RationalWord *other) {
         Partials.push_back(Partial);
         if (Partials.size() >= Tuppence_LOOP_LIMIT) {
             LogWarning((std::string("Loop limit exceeded in RationalWord divide. Returning truncated result. Loop limit is: ") + std::to_string(Tuppence_LOOP_LIMIT)).c_str());
+            auto TransientBuilder = FiniteWordBuilder_create();
+            FiniteWordBuilder_append(TransientBuilder, Transient);
             for (auto TransientIter = Partials.begin(); TransientIter < Partials.end(); TransientIter++) {
-                Transient = FiniteWord_concatenate(RationalWord_residue(*TransientIter, 1), Transient);
+                FiniteWordBuilder_append(TransientBuilder, RationalWord_residue(*TransientIter, 1));
             }
+            Transient = FiniteWordBuilder_finish(TransientBuilder);
             return RationalWord_createFromPeriodTransient(FiniteWord_ZERO_1BIT, Transient);
         }
     }
@@ -32,3 +32,10 @@ uint64_t Math_bitLength(uint64_t n) {
     }
     return r;
 }
+
+// the splitmix64 finalizer
+uint64_t Math_mixHash(uint64_t n) {
+    n = (n ^ (n >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    n = (n ^ (n >> 27)) * 0x94d049bb133111ebULL;
+    return n ^ (n >> 31);
+}
@@ -12,6 +12,7 @@
 #include "../common/Lexer.h"
 #include "../common/List.h"
 #include "../common/RationalWord.h"
+#include "../common/WordVector.h"
 // #include "../tuppence/Logger.h"
 // #include "../tuppence/Value.h"
 // #include "FiniteWordImpl.h"
@@ -24,6 +25,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
 #include <vector>
 #include <string.h>
 
@@ -48,6 +50,8 @@ TuppenceValue *TuppenceValue_TRANSIENT;
 TuppenceValue *TuppenceValue_PERIOD;
 TuppenceValue *TuppenceValue_NUMERATOR;
 TuppenceValue *TuppenceValue_DENOMINATOR;
+TuppenceValue *TuppenceValue_VECTOR;
+TuppenceValue *TuppenceValue_LIST;
 
 void Value_initialize() {
     FiniteWord_initialize();
@@ -76,6 +80,8 @@ void Value_initialize() {
     TuppenceValue_PERIOD = Value_createFromBuiltinFunction(BuiltinFunction_PERIOD);
     TuppenceValue_NUMERATOR = Value_createFromBuiltinFunction(BuiltinFunction_NUMERATOR);
     TuppenceValue_DENOMINATOR = Value_createFromBuiltinFunction(BuiltinFunction_DENOMINATOR);
+    TuppenceValue_VECTOR = Value_createFromBuiltinFunction(BuiltinFunction_VECTOR);
+    TuppenceValue_LIST = Value_createFromBuiltinFunction(BuiltinFunction_LIST);
 }
 
 
@@ -139,6 +145,14 @@ TuppenceValue *Value_createFromBuiltinFunction(BuiltinFunction *F) {
     return val;
 }
 
+TuppenceValue *Value_createFromWordVector(WordVector *vector) {
+    TuppenceValue *val = new TuppenceValue;
+    val->tag = WordVectorTag;
+    // never modified, so it can be shared
+    val->vector = vector;
+    return val;
+}
+
 TuppenceValue *Value_createFromValue(TuppenceValue *val) {
     switch (val->tag) {
         case FiniteWordTag:
@@ -149,6 +163,8 @@ TuppenceValue *Value_createFromValue(TuppenceValue *val) {
             return Value_createFromList(val->list);
         case BuiltinFunctionTag:
             return Value_createFromBuiltinFunction(val->builtinFunction);
+        case WordVectorTag:
+            return Value_createFromWordVector(val->vector);
         default:
             assert(false);
     }
@@ -180,6 +196,9 @@ int Value_CreateString(TuppenceValue *val, char** str_p) {
         case BuiltinFunctionTag:
             BuiltinFunction_newString(val->builtinFunction, str_p);
             break;
+        case WordVectorTag:
+            WordVector_newString(val->vector, str_p);
+            break;
         default:
             llvm_unreachable("fallthrough");
     }
@@ -534,6 +553,40 @@ TuppenceValue *Value_Binary(char Op, TuppenceValue *LL, TuppenceValue *RR) {
                     return Value_createFromError((std::string("Invalid types for ") + stringFromToken(Op) + ": " + Lstr + " " + Rstr).c_str());
                 }
             }
+            else if (LVal->tag == WordVectorTag) {
+                auto WordVectorL = LVal->vector;
+                if (RVal->tag == WordVectorTag) {
+                    auto WordVectorR = RVal->vector;
+                    if (WordVector_width(WordVectorL) != WordVector_width(WordVectorR) ||
+                        WordVector_count(WordVectorL) != WordVector_count(WordVectorR)) {
+                        char *Lstr;
+                        Value_CreateString(LVal, &Lstr);
+                        char *Rstr;
+                        Value_CreateString(RVal, &Rstr);
+                        return Value_createFromError((std::string("Expected same sizes for ") + stringFromToken(Op) + ": " + Lstr + " " + Rstr).c_str());
+                    }
+                    
+                    std::vector<WordVector *> Args;
+                    Args.push_back(WordVectorR);
+                    Args.push_back(WordVectorL);
+                    
+                    WordVector *Lo;
+                    WordVector *Hi;
+                    WordVector_arraySubtract(&Args[0], 2, &Hi, &Lo);
+                    
+                    std::vector<TuppenceValue *> Vals;
+                    Vals.push_back(Value_createFromWordVector(Lo));
+                    Vals.push_back(Value_createFromWordVector(Hi));
+                    return Value_createFromList(List_createFromVals(&Vals[0], Vals.size()));
+                }
+                else {
+                    char *Lstr;
+                    Value_CreateString(LVal, &Lstr);
+                    char *Rstr;
+                    Value_CreateString(RVal, &Rstr);
+                    return Value_createFromError((std::string("Invalid types for ") + stringFromToken(Op) + ": " + Lstr + " " + Rstr).c_str());
+                }
+            }
             else if (LVal->tag == RationalWordTag) {
                 auto RationalWordL = LVal->rational;
                 if (RVal->tag == RationalWordTag) {
@@ -678,6 +731,44 @@ TuppenceValue *Value_Infix(char Op, TuppenceValue **Args, size_t Count) {
     
     std::vector<TuppenceValue *> Vals(Args, Args + Count);
     
+    // WordVectors only combine with other WordVectors, and the operator is applied to each word
+    if (std::all_of(Vals.begin(), Vals.end(), [](TuppenceValue *Val) { return Val->tag == WordVectorTag; })) {
+        std::vector<WordVector *> WordVectorVals;
+        
+        // use first sizes that are encountered
+        auto Width = WordVector_width(Vals[0]->vector);
+        auto VectorCount = WordVector_count(Vals[0]->vector);
+        for (auto& Val : Vals) {
+            auto WordVectorVal = Val->vector;
+            if (WordVector_width(WordVectorVal) != Width || WordVector_count(WordVectorVal) != VectorCount) {
+                char *str;
+                Value_CreateString(Val, &str);
+                std::string s = std::string(str);
+                return Value_createFromError((std::string("Expected same sizes for ") + stringFromToken(Op) + ": " + s).c_str());
+            }
+            WordVectorVals.push_back(WordVectorVal);
+        }
+        
+        switch (Op) {
+            case '+': {
+                WordVector *Lo;
+                WordVector *Hi;
+                WordVector_arrayPlus(&WordVectorVals[0], WordVectorVals.size(), &Hi, &Lo);
+                std::vector<TuppenceValue *> Vals;
+                Vals.push_back(Value_createFromWordVector(Lo));
+                Vals.push_back(Value_createFromWordVector(Hi));
+                return Value_createFromList(List_createFromVals(&Vals[0], Vals.size()));
+            }
+            case '|': return Value_createFromWordVector(WordVector_arrayOr(&WordVectorVals[0], WordVectorVals.size()));
+            case '&': return Value_createFromWordVector(WordVector_arrayAnd(&WordVectorVals[0], WordVectorVals.size()));
+            case '^': return Value_createFromWordVector(WordVector_arrayXor(&WordVectorVals[0], WordVectorVals.size()));
+            case tok_equal_equal: return Value_createFromWordVector(WordVector_arrayEqual(&WordVectorVals[0], WordVectorVals.size()));
+            case tok_bang_equal: return Value_createFromWordVector(WordVector_arrayNotEqual(&WordVectorVals[0], WordVectorVals.size()));
+            default:
+                return Value_createFromError((std::string("Infix operator not found for WordVector: ") + stringFromToken(Op)).c_str());
+        }
+    }
+    
     if (Op == tok_equal_equal || Op == tok_bang_equal) {
         // == and != operators are special, if any word values are present, then only consider
         // the first element of any lists
@@ -0,0 +1,364 @@
+//===------ WordVector.cpp ------------------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "../common/WordVector.h"
+
+#include "BitKernels.h"
+
+#include "../common/FiniteWord.h"
+#include "../common/List.h"
+#include "../common/TuppenceMath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <vector>
+
+static const size_t LANES = 64;
+
+static inline size_t numGroups(size_t Count) {
+    return (Count + LANES - 1) / LANES;
+}
+
+static inline size_t numLimbs(size_t Width) {
+    return (Width + 63) / 64;
+}
+
+struct WordVector {
+    size_t Width;
+    size_t Count;
+    /// Width slices of numGroups(Count) limbs each
+    /// Bit l of limb g of slice b is bit b of word g * 64 + l
+    /// Lanes past Count are always 0
+    std::vector<uint64_t> Slices;
+
+    WordVector(size_t Width, size_t Count) :
+        Width(Width),
+        Count(Count),
+        Slices(Width * numGroups(Count), 0) {}
+
+    uint64_t *slice(size_t b) {
+        return Slices.data() + b * numGroups(Count);
+    }
+};
+
+/// Lanes of group g that hold words
+static inline uint64_t laneMask(size_t Count, size_t g) {
+    auto Used = Count - g * LANES;
+    return Used >= LANES ? ~(uint64_t)0 : ((uint64_t)1 << Used) - 1;
+}
+
+static inline void assertSameShape(WordVector *A, WordVector *B) {
+    assert(A->Width == B->Width && A->Count == B->Count && "Shapes not equal");
+    (void)A;
+    (void)B;
+}
+
+/// Transpose the 64x64 bit matrix with rows M[i], so bit j of M[i] becomes bit i of M[j]
+static void transpose64(uint64_t *M) {
+    uint64_t Mask = 0x00000000FFFFFFFFULL;
+    for (size_t j = 32; j != 0; j >>= 1, Mask ^= Mask << j) {
+        for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            auto T = ((M[k] >> j) ^ M[k | j]) & Mask;
+            M[k] ^= T << j;
+            M[k | j] ^= T;
+        }
+    }
+}
+
+/// The slices from First up to First + Width as a new vector
+static WordVector *extractSlices(WordVector *V, size_t First, size_t Width) {
+    auto Result = new WordVector(Width, V->Count);
+    std::copy_n(V->slice(First), Result->Slices.size(), Result->Slices.begin());
+    return Result;
+}
+
+WordVector *WordVector_createFromWords(FiniteWord **Words, size_t Count) {
+    assert(Count > 0 && "Words is empty");
+
+    auto Width = FiniteWord_size(Words[0]);
+    auto Result = new WordVector(Width, Count);
+    auto Groups = numGroups(Count);
+    auto Limbs = numLimbs(Width);
+
+    // each group of 64 words is turned into slices one limb column at a time
+    std::vector<uint64_t> Block(LANES * Limbs);
+    uint64_t Matrix[LANES];
+    for (size_t g = 0; g < Groups; g++) {
+        auto Lanes = std::min(LANES, Count - g * LANES);
+        std::fill(Block.begin(), Block.end(), 0);
+        for (size_t l = 0; l < Lanes; l++) {
+            assert(FiniteWord_size(Words[g * LANES + l]) == Width && "Sizes not equal");
+            FiniteWord_copyLimbs(Words[g * LANES + l], &Block[l * Limbs]);
+        }
+        for (size_t j = 0; j < Limbs; j++) {
+            for (size_t l = 0; l < LANES; l++) {
+                Matrix[l] = Block[l * Limbs + j];
+            }
+            transpose64(Matrix);
+            auto Bits = std::min<size_t>(64, Width - j * 64);
+            for (size_t b = 0; b < Bits; b++) {
+                Result->slice(j * 64 + b)[g] = Matrix[b];
+            }
+        }
+    }
+    return Result;
+}
+
+WordVector *WordVector_createFromList(List *list) {
+    auto Size = List_size(list);
+    if (Size == 0) {
+        return nullptr;
+    }
+    auto Data = List_data(list);
+    std::vector<FiniteWord *> Words;
+    for (size_t i = 0; i < Size; i++) {
+        if (Data[i]->tag != FiniteWordTag) {
+            return nullptr;
+        }
+        if (FiniteWord_size(Data[i]->finite) != FiniteWord_size(Data[0]->finite)) {
+            return nullptr;
+        }
+        Words.push_back(Data[i]->finite);
+    }
+    return WordVector_createFromWords(&Words[0], Words.size());
+}
+
+List *WordVector_toList(WordVector *vector) {
+    auto Width = vector->Width;
+    auto Count = vector->Count;
+    auto Limbs = numLimbs(Width);
+
+    std::vector<TuppenceValue *> Vals;
+    Vals.reserve(Count);
+    std::vector<uint64_t> Block(LANES * Limbs);
+    uint64_t Matrix[LANES];
+    for (size_t g = 0; g < numGroups(Count); g++) {
+        for (size_t j = 0; j < Limbs; j++) {
+            auto Bits = std::min<size_t>(64, Width - j * 64);
+            std::fill(Matrix, Matrix + LANES, 0);
+            for (size_t b = 0; b < Bits; b++) {
+                Matrix[b] = vector->slice(j * 64 + b)[g];
+            }
+            transpose64(Matrix);
+            for (size_t l = 0; l < LANES; l++) {
+                Block[l * Limbs + j] = Matrix[l];
+            }
+        }
+        auto Lanes = std::min(LANES, Count - g * LANES);
+        for (size_t l = 0; l < Lanes; l++) {
+            Vals.push_back(Value_createFromFiniteWord(FiniteWord_createFromLimbs(Width, Block.data() + l * Limbs)));
+        }
+    }
+    return List_createFromVals(&Vals[0], Vals.size());
+}
+
+int32_t WordVector_newString(WordVector *vector, char **str) {
+
+    std::ostringstream strs;
+
+    // iterate reversed for printing, as for List
+    strs << "vector(";
+    for (size_t i = vector->Count; i-- > 0;) {
+        char *wordStr;
+        FiniteWord_newString(WordVector_get(vector, i), &wordStr);
+        strs << wordStr;
+        if (i != 0) {
+            strs << ", ";
+        }
+    }
+    strs << ")";
+    std::string resStr = strs.str();
+
+    auto cStr = new char[resStr.size() + 1];
+    resStr.copy(cStr, resStr.size());
+    cStr[resStr.size()] = '\0';
+
+    *str = cStr;
+
+    return 0;
+}
+
+size_t WordVector_width(WordVector *vector) {
+    return vector->Width;
+}
+
+size_t WordVector_count(WordVector *vector) {
+    return vector->Count;
+}
+
+FiniteWord *WordVector_get(WordVector *vector, size_t idx) {
+    assert(idx < vector->Count && "Index out of range");
+    auto g = idx / LANES;
+    auto l = idx % LANES;
+    std::vector<uint64_t> Limbs(numLimbs(vector->Width), 0);
+    for (size_t b = 0; b < vector->Width; b++) {
+        Limbs[b / 64] |= ((vector->slice(b)[g] >> l) & 1) << (b % 64);
+    }
+    return FiniteWord_createFromLimbs(vector->Width, Limbs.data());
+}
+
+static WordVector *arrayBitwise(WordVector **Values, size_t Count, BitKernels_BinaryFunction Kernel) {
+    assert(Count > 1 && "Vals does not contain more than one element");
+    auto Result = new WordVector(*Values[0]);
+    for (size_t i = 1; i < Count; i++) {
+        assertSameShape(Result, Values[i]);
+        Kernel(Result->Slices.data(), Result->Slices.data(), Values[i]->Slices.data(), Result->Slices.size());
+    }
+    return Result;
+}
+
+WordVector *WordVector_arrayOr(WordVector **Values, size_t Count) {
+    return arrayBitwise(Values, Count, BitKernels_or);
+}
+
+WordVector *WordVector_arrayAnd(WordVector **Values, size_t Count) {
+    return arrayBitwise(Values, Count, BitKernels_and);
+}
+
+WordVector *WordVector_arrayXor(WordVector **Values, size_t Count) {
+    return arrayBitwise(Values, Count, BitKernels_xor);
+}
+
+void WordVector_arrayPlus(WordVector **Values, size_t Count, WordVector **Hi, WordVector **Lo) {
+    assert(Count > 1 && "Vals does not contain more than one element");
+    auto Width = Values[0]->Width;
+    auto CarryWidth = Math_bitLength(Count - 1);
+    auto Groups = numGroups(Values[0]->Count);
+
+    // ripple-carry adder with one full adder per slice, for 64 words at a time
+    auto Sum = new WordVector(Width + CarryWidth, Values[0]->Count);
+    std::vector<uint64_t> Carry(Groups);
+    for (size_t i = 0; i < Count; i++) {
+        assertSameShape(Values[0], Values[i]);
+        std::fill(Carry.begin(), Carry.end(), 0);
+        for (size_t b = 0; b < Width; b++) {
+            auto S = Sum->slice(b);
+            auto X = Values[i]->slice(b);
+            for (size_t g = 0; g < Groups; g++) {
+                auto Half = S[g] ^ X[g];
+                S[g] = Half ^ Carry[g];
+                Carry[g] = (X[g] & ~Half) | (Carry[g] & Half);
+            }
+        }
+        for (size_t b = Width; b < Width + CarryWidth; b++) {
+            auto S = Sum->slice(b);
+            uint64_t Any = 0;
+            for (size_t g = 0; g < Groups; g++) {
+                auto Next = S[g] & Carry[g];
+                S[g] ^= Carry[g];
+                Carry[g] = Next;
+                Any |= Next;
+            }
+            if (Any == 0) {
+                break;
+            }
+        }
+    }
+
+    *Lo = extractSlices(Sum, 0, Width);
+    *Hi = extractSlices(Sum, Width, CarryWidth);
+}
+
+void WordVector_arraySubtract(WordVector **Values, size_t Count, WordVector **Hi, WordVector **Lo) {
+    assert(Count == 2);
+    WordVector *R = Values[0];
+    WordVector *L = Values[1];
+    assertSameShape(L, R);
+    auto Groups = numGroups(L->Count);
+
+    auto Difference = new WordVector(L->Width, L->Count);
+    auto Borrow = new WordVector(1, L->Count);
+    auto B = Borrow->slice(0);
+    for (size_t b = 0; b < L->Width; b++) {
+        auto D = Difference->slice(b);
+        auto X = L->slice(b);
+        auto Y = R->slice(b);
+        for (size_t g = 0; g < Groups; g++) {
+            auto Half = X[g] ^ Y[g];
+            D[g] = Half ^ B[g];
+            B[g] = (~X[g] & Y[g]) | (~Half & B[g]);
+        }
+    }
+
+    *Lo = Difference;
+    *Hi = Borrow;
+}
+
+WordVector *WordVector_countPopulation(WordVector *vector) {
+    auto Groups = numGroups(vector->Count);
+
+    // add each slice into a counter of CountWidth slices
+    auto Result = new WordVector(Math_bitLength(vector->Width), vector->Count);
+    std::vector<uint64_t> Carry(Groups);
+    for (size_t b = 0; b < vector->Width; b++) {
+        std::copy_n(vector->slice(b), Groups, Carry.begin());
+        for (size_t k = 0; k < Result->Width; k++) {
+            auto C = Result->slice(k);
+            uint64_t Any = 0;
+            for (size_t g = 0; g < Groups; g++) {
+                auto Next = C[g] & Carry[g];
+                C[g] ^= Carry[g];
+                Carry[g] = Next;
+                Any |= Next;
+            }
+            if (Any == 0) {
+                break;
+            }
+        }
+    }
+    return Result;
+}
+
+/// Clear the lanes of Mask where A and B hold different words
+static void maskEqualLanes(WordVector *A, WordVector *B, uint64_t *Mask) {
+    assertSameShape(A, B);
+    auto Groups = numGroups(A->Count);
+    for (size_t b = 0; b < A->Width; b++) {
+        auto X = A->slice(b);
+        auto Y = B->slice(b);
+        for (size_t g = 0; g < Groups; g++) {
+            Mask[g] &= ~(X[g] ^ Y[g]);
+        }
+    }
+}
+
+WordVector *WordVector_arrayEqual(WordVector **ToTest, size_t Count) {
+    assert(Count > 1 && "ToTest does not contain more than one element");
+    auto Result = new WordVector(1, ToTest[0]->Count);
+    auto Mask = Result->slice(0);
+    for (size_t g = 0; g < numGroups(Result->Count); g++) {
+        Mask[g] = laneMask(Result->Count, g);
+    }
+    for (size_t i = 1; i < Count; i++) {
+        maskEqualLanes(ToTest[0], ToTest[i], Mask);
+    }
+    return Result;
+}
+
+WordVector *WordVector_arrayNotEqual(WordVector **ToTest, size_t Count) {
+    assert(Count > 1 && "ToTest does not contain more than one element");
+    auto Result = new WordVector(1, ToTest[0]->Count);
+    auto Groups = numGroups(Result->Count);
+    auto Distinct = Result->slice(0);
+    for (size_t g = 0; g < Groups; g++) {
+        Distinct[g] = laneMask(Result->Count, g);
+    }
+    std::vector<uint64_t> Mask(Groups);
+    for (size_t i = 0; i < Count; i++) {
+        for (size_t j = i + 1; j < Count; j++) {
+            std::fill(Mask.begin(), Mask.end(), ~(uint64_t)0);
+            maskEqualLanes(ToTest[i], ToTest[j], Mask.data());
+            for (size_t g = 0; g < Groups; g++) {
+                Distinct[g] &= ~Mask[g];
+            }
+        }
+    }
+    return Result;
+}
@@ -0,0 +1,75 @@
+//===------ FiniteWord.bench.cpp ------------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+//
+// Timings of FiniteWord reverse and rotate for widths from 1 bit to 10 Mbit
+//
+// Usage: runBenchmarks [seconds per measurement]
+//
+
+#include "common/FiniteWord.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+static double MinimumSeconds = 0.2;
+
+/// Seconds per call, repeating until MinimumSeconds have passed
+template <typename Function>
+static double measure(Function F) {
+    size_t Iterations = 0;
+    auto Start = std::chrono::steady_clock::now();
+    double Elapsed = 0;
+    do {
+        F();
+        Iterations++;
+        Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    } while (Elapsed < MinimumSeconds);
+    return Elapsed / Iterations;
+}
+
+/// Built from 64-bit pieces, which is quicker than parsing a string of the whole width
+static FiniteWord *randomWord(size_t Size, std::mt19937_64 &Random) {
+    auto Builder = FiniteWordBuilder_create();
+    for (size_t Filled = 0; Filled < Size; Filled += 64) {
+        auto Count = std::min<size_t>(64, Size - Filled);
+        auto Bits = Count == 64 ? Random() : Random() & ((UINT64_C(1) << Count) - 1);
+        FiniteWordBuilder_append(Builder, FiniteWord_createFromVal(Count, Bits));
+    }
+    return FiniteWordBuilder_finish(Builder);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        MinimumSeconds = atof(argv[1]);
+    }
+
+    FiniteWord_initialize();
+
+    const size_t Widths[] = { 1, 7, 64, 65, 1000, 4096, 65536, 1000003, 10000000 };
+    std::mt19937_64 Random(0);
+
+    printf("%10s %14s %14s %14s\n", "bits", "reverse (s)", "rotateLeft (s)", "rotateRight (s)");
+    for (auto Width : Widths) {
+        auto Word = randomWord(Width, Random);
+        // an amount that is not a multiple of the limb size
+        auto Amount = Width / 3 + 1;
+
+        auto Reverse = measure([&]() { FiniteWord_reverse(Word); });
+        auto Left = measure([&]() { FiniteWord_rotateLeft(Word, Amount); });
+        auto Right = measure([&]() { FiniteWord_rotateRight(Word, Amount); });
+
+        printf("%10zu %14.3e %14.3e %14.3e\n", Width, Reverse, Left, Right);
+    }
+
+    return 0;
+}
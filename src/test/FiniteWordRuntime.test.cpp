@@ -0,0 +1,493 @@
+//===------ FiniteWordRuntime.test.cpp ------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+//
+// FiniteWord arithmetic through the runtime's C API
+//
+// Operand sizes are picked on both sides of each cutoff where the runtime
+// changes algorithm or representation, and results are checked against
+// plain schoolbook and bit-at-a-time references written here.
+//
+
+#include "common/FiniteWord.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef std::vector<uint64_t> Limbs;
+
+/// One bit per element, least significant first
+typedef std::vector<uint8_t> Bits;
+
+class FiniteWordRuntimeTest : public ::testing::Test {
+protected:
+
+    FiniteWordRuntimeTest() : Random(0) {}
+
+    static void SetUpTestCase() {
+        FiniteWord_initialize();
+    }
+
+    std::mt19937_64 Random;
+
+    /// Count random limbs, the top one not 0
+    Limbs randomLimbs(size_t Count) {
+        Limbs L(Count);
+        for (auto &Limb : L) {
+            Limb = Random();
+        }
+        if (L.back() == 0) {
+            L.back() = 1;
+        }
+        return L;
+    }
+};
+
+static size_t numLimbs(size_t Size) {
+    return (Size + 63) / 64;
+}
+
+static Limbs limbsOf(FiniteWord *word) {
+    Limbs L(numLimbs(FiniteWord_size(word)));
+    FiniteWord_copyLimbs(word, L.data());
+    return L;
+}
+
+/// L zero-extended or truncated to Size bits
+static FiniteWord *wordOf(Limbs L, size_t Size) {
+    L.resize(numLimbs(Size));
+    return FiniteWord_createFromLimbs(Size, L.data());
+}
+
+static void trim(Limbs &L) {
+    while (!L.empty() && L.back() == 0) {
+        L.pop_back();
+    }
+}
+
+/// Full product, with 32-bit digits so that each partial product fits in 64 bits
+static Limbs multiplySchoolbook(const Limbs &A, const Limbs &B) {
+    std::vector<uint32_t> a;
+    std::vector<uint32_t> b;
+    for (auto Limb : A) {
+        a.push_back(static_cast<uint32_t>(Limb));
+        a.push_back(static_cast<uint32_t>(Limb >> 32));
+    }
+    for (auto Limb : B) {
+        b.push_back(static_cast<uint32_t>(Limb));
+        b.push_back(static_cast<uint32_t>(Limb >> 32));
+    }
+    std::vector<uint32_t> Product(a.size() + b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        uint64_t Carry = 0;
+        for (size_t j = 0; j < b.size(); j++) {
+            auto t = static_cast<uint64_t>(a[i]) * b[j] + Product[i + j] + Carry;
+            Product[i + j] = static_cast<uint32_t>(t);
+            Carry = t >> 32;
+        }
+        Product[i + b.size()] = static_cast<uint32_t>(Carry);
+    }
+    Limbs P(A.size() + B.size());
+    for (size_t i = 0; i < P.size(); i++) {
+        P[i] = Product[2 * i] | (static_cast<uint64_t>(Product[2 * i + 1]) << 32);
+    }
+    trim(P);
+    return P;
+}
+
+static Limbs addLimbs(Limbs A, const Limbs &B) {
+    A.resize(std::max(A.size(), B.size()) + 1);
+    uint64_t Carry = 0;
+    for (size_t i = 0; i < A.size(); i++) {
+        auto b = i < B.size() ? B[i] : 0;
+        auto Sum = A[i] + b;
+        auto NextCarry = static_cast<uint64_t>(Sum < A[i]);
+        Sum += Carry;
+        NextCarry |= static_cast<uint64_t>(Sum < Carry);
+        A[i] = Sum;
+        Carry = NextCarry;
+    }
+    trim(A);
+    return A;
+}
+
+static Bits bitsOf(FiniteWord *word) {
+    auto Size = FiniteWord_size(word);
+    auto L = limbsOf(word);
+    Bits B(Size);
+    for (size_t i = 0; i < Size; i++) {
+        B[i] = (L[i / 64] >> (i % 64)) & 1;
+    }
+    return B;
+}
+
+static FiniteWord *wordOfBits(const Bits &B) {
+    Limbs L(numLimbs(B.size()));
+    for (size_t i = 0; i < B.size(); i++) {
+        L[i / 64] |= static_cast<uint64_t>(B[i]) << (i % 64);
+    }
+    return FiniteWord_createFromLimbs(B.size(), L.data());
+}
+
+//
+// Multiply, across the schoolbook, Karatsuba, Toom-3 and NTT cutoffs
+//
+
+/// Product of A and B, at the width of the whole product
+static void expectFullProduct(const Limbs &A, const Limbs &B) {
+    auto Size = 64 * (A.size() + B.size());
+    auto Product = FiniteWord_multiply(wordOf(A, Size), wordOf(B, Size));
+    auto Expected = multiplySchoolbook(A, B);
+    auto Actual = limbsOf(Product);
+    trim(Actual);
+    EXPECT_TRUE(Actual == Expected) << A.size() << " by " << B.size() << " limbs";
+}
+
+TEST_F(FiniteWordRuntimeTest, MultiplyCutoffs) {
+    // KARATSUBA_THRESHOLD 32, TOOM3_THRESHOLD 160, NTT_THRESHOLD 4096 limbs
+    const size_t Sizes[] = { 31, 32, 33, 159, 160, 161, 4095, 4096 };
+    for (auto Size : Sizes) {
+        expectFullProduct(randomLimbs(Size), randomLimbs(Size));
+    }
+}
+
+TEST_F(FiniteWordRuntimeTest, MultiplyUnbalanced) {
+    // the larger operand is cut into pieces of the smaller one's size
+    expectFullProduct(randomLimbs(400), randomLimbs(40));
+    expectFullProduct(randomLimbs(1000), randomLimbs(170));
+    expectFullProduct(randomLimbs(5000), randomLimbs(4096));
+}
+
+TEST_F(FiniteWordRuntimeTest, MultiplyTruncated) {
+    // same-size operands keep only the low limbs of the product
+    for (size_t Count : { 20, 100, 300 }) {
+        auto A = randomLimbs(Count);
+        auto B = randomLimbs(Count);
+        auto Size = 64 * Count - 5;
+        auto Product = limbsOf(FiniteWord_multiply(wordOf(A, Size), wordOf(B, Size)));
+        auto Expected = limbsOf(wordOf(multiplySchoolbook(limbsOf(wordOf(A, Size)), limbsOf(wordOf(B, Size))), Size));
+        EXPECT_TRUE(Product == Expected) << Count << " limbs";
+    }
+}
+
+//
+// Divide, across the Newton cutoff
+//
+
+/// Quotient * Divisor + Remainder is the dividend, and Remainder < Divisor
+static void expectDivision(const Limbs &N, const Limbs &D) {
+    auto Size = 64 * std::max(N.size(), D.size());
+    auto Dividend = wordOf(N, Size);
+    auto Divisor = wordOf(D, Size);
+    FiniteWord *Quotient;
+    FiniteWord *Remainder;
+    FiniteWord_udivrem(Dividend, Divisor, &Quotient, &Remainder);
+
+    auto Q = limbsOf(Quotient);
+    trim(Q);
+    auto R = limbsOf(Remainder);
+    trim(R);
+    auto Expected = N;
+    trim(Expected);
+    EXPECT_TRUE(addLimbs(multiplySchoolbook(Q, D), R) == Expected) << N.size() << " by " << D.size() << " limbs";
+    EXPECT_TRUE(FiniteWord_ugt(Divisor, Remainder));
+
+    EXPECT_TRUE(FiniteWord_equal(FiniteWord_udiv(Dividend, Divisor), Quotient));
+    EXPECT_TRUE(FiniteWord_equal(FiniteWord_urem(Dividend, Divisor), Remainder));
+}
+
+TEST_F(FiniteWordRuntimeTest, DivideCutoffs) {
+    // NEWTON_THRESHOLD 512 limbs of the divisor
+    const size_t Sizes[] = { 1, 2, 40, 511, 512, 513 };
+    for (auto Size : Sizes) {
+        expectDivision(randomLimbs(Size + 700), randomLimbs(Size));
+        expectDivision(randomLimbs(2 * Size), randomLimbs(Size));
+    }
+}
+
+TEST_F(FiniteWordRuntimeTest, DivideEdges) {
+    auto D = randomLimbs(600);
+    // smaller dividend, equal dividend, and an exact multiple
+    expectDivision(randomLimbs(599), D);
+    expectDivision(D, D);
+    expectDivision(multiplySchoolbook(D, randomLimbs(300)), D);
+    // divisor of a single 1 bit at the top
+    Limbs Power(600);
+    Power.back() = UINT64_C(1) << 63;
+    expectDivision(randomLimbs(1200), Power);
+}
+
+//
+// GCD, against Euclid's algorithm on FiniteWord_urem
+//
+
+static FiniteWord *euclid(FiniteWord *A, FiniteWord *B) {
+    auto Zero = FiniteWord_createFromVal(FiniteWord_size(A), 0);
+    while (!FiniteWord_equal(B, Zero)) {
+        auto Remainder = FiniteWord_urem(A, B);
+        A = B;
+        B = Remainder;
+    }
+    return A;
+}
+
+TEST_F(FiniteWordRuntimeTest, GcdCutoffs) {
+    // BINARY_GCD_THRESHOLD 2 limbs, and words of a single limb
+    const size_t Sizes[] = { 1, 2, 3, 40, 100 };
+    for (auto Size : Sizes) {
+        auto Width = 64 * 2 * Size;
+        // a shared factor, so the result is not almost always 1
+        auto Factor = randomLimbs(Size);
+        auto A = wordOf(multiplySchoolbook(randomLimbs(Size), Factor), Width);
+        auto B = wordOf(multiplySchoolbook(randomLimbs(Size), Factor), Width);
+        EXPECT_TRUE(FiniteWord_equal(FiniteWord_gcd(A, B), euclid(A, B))) << Size << " limbs";
+
+        auto C = wordOf(randomLimbs(2 * Size), Width);
+        auto D = wordOf(randomLimbs(Size), Width);
+        EXPECT_TRUE(FiniteWord_equal(FiniteWord_gcd(C, D), euclid(C, D))) << Size << " limbs";
+    }
+}
+
+//
+// Views, sparse words and repeats, against the same bits as an ordinary word
+//
+
+/// Operations on word agree with the reference on Expected, its bits
+static void expectSameBits(FiniteWord *word, const Bits &Expected, std::mt19937_64 &Random) {
+    auto Size = Expected.size();
+    ASSERT_EQ(FiniteWord_size(word), Size);
+    EXPECT_TRUE(bitsOf(word) == Expected);
+
+    auto Ordinary = wordOfBits(Expected);
+    EXPECT_TRUE(FiniteWord_equal(word, Ordinary));
+    EXPECT_EQ(FiniteWord_hash(word), FiniteWord_hash(Ordinary));
+    EXPECT_EQ(FiniteWord_countPopulation(word), static_cast<size_t>(std::count(Expected.begin(), Expected.end(), 1)));
+    for (int i = 0; i < 20; i++) {
+        auto Position = Random() % Size;
+        EXPECT_EQ(FiniteWord_getBit(word, Position), Expected[Position]);
+    }
+
+    Bits Dense(Size);
+    for (auto &Bit : Dense) {
+        Bit = Random() & 1;
+    }
+    auto Other = wordOfBits(Dense);
+
+    Bits Not(Size);
+    Bits And(Size);
+    Bits Or(Size);
+    Bits Xor(Size);
+    Bits Sum(Size);
+    uint8_t Carry = 0;
+    for (size_t i = 0; i < Size; i++) {
+        Not[i] = !Expected[i];
+        And[i] = Expected[i] & Dense[i];
+        Or[i] = Expected[i] | Dense[i];
+        Xor[i] = Expected[i] ^ Dense[i];
+        auto Total = Expected[i] + Dense[i] + Carry;
+        Sum[i] = Total & 1;
+        Carry = Total >> 1;
+    }
+    EXPECT_TRUE(bitsOf(FiniteWord_not(word)) == Not);
+    EXPECT_TRUE(bitsOf(FiniteWord_and(word, Other)) == And);
+    EXPECT_TRUE(bitsOf(FiniteWord_or(word, Other)) == Or);
+    EXPECT_TRUE(bitsOf(FiniteWord_xor(word, Other)) == Xor);
+    EXPECT_TRUE(bitsOf(FiniteWord_add(word, Other)) == Sum);
+
+    auto Amount = Random() % Size;
+    Bits Rotated(Size);
+    Bits Reversed(Size);
+    for (size_t i = 0; i < Size; i++) {
+        Rotated[(i + Amount) % Size] = Expected[i];
+        Reversed[Size - 1 - i] = Expected[i];
+    }
+    EXPECT_TRUE(bitsOf(FiniteWord_rotateLeft(word, Amount)) == Rotated);
+    EXPECT_TRUE(bitsOf(FiniteWord_reverse(word)) == Reversed);
+
+    auto Cut = 1 + Random() % (Size - 1);
+    EXPECT_TRUE(bitsOf(FiniteWord_residue(word, Cut)) == Bits(Expected.begin(), Expected.begin() + Cut));
+    EXPECT_TRUE(bitsOf(FiniteWord_shiftRight(word, Cut)) == Bits(Expected.begin() + Cut, Expected.end()));
+
+    Bits Concatenated(Dense);
+    Concatenated.insert(Concatenated.end(), Expected.begin(), Expected.end());
+    EXPECT_TRUE(bitsOf(FiniteWord_concatenate(word, Other)) == Concatenated);
+}
+
+TEST_F(FiniteWordRuntimeTest, Views) {
+    for (int i = 0; i < 5; i++) {
+        auto Base = wordOf(randomLimbs(numLimbs(5000)), 5000);
+        auto Expected = bitsOf(Base);
+
+        // both ends cut off, at offsets that are not on limb boundaries
+        auto Offset = 1 + Random() % 200;
+        auto Size = 3000 + Random() % 1000;
+        auto View = FiniteWord_residue(FiniteWord_shiftRight(Base, Offset), Size);
+        expectSameBits(View, Bits(Expected.begin() + Offset, Expected.begin() + Offset + Size), Random);
+
+        // a view of a view
+        auto Inner = FiniteWord_shiftRight(View, 70);
+        expectSameBits(Inner, Bits(Expected.begin() + Offset + 70, Expected.begin() + Offset + Size), Random);
+    }
+}
+
+TEST_F(FiniteWordRuntimeTest, SparseCutoff) {
+    // words of at least 4096 bits with under one set bit per 256 are sparse
+    const size_t Sizes[] = { 4095, 4096, 10000 };
+    for (auto Size : Sizes) {
+        for (size_t SetBits : { 0, 1, 3, 12 }) {
+            Bits Expected(Size);
+            for (size_t i = 0; i < SetBits; i++) {
+                Expected[Random() % Size] = 1;
+            }
+            // the top bit set, so a shifted set bit can carry out of the word
+            if (SetBits == 3) {
+                Expected[Size - 1] = 1;
+            }
+            expectSameBits(wordOfBits(Expected), Expected, Random);
+        }
+    }
+
+    // two sparse words together
+    Bits A(8192);
+    Bits B(8192);
+    A[5] = A[4000] = A[8191] = 1;
+    B[5] = B[100] = B[8191] = 1;
+    auto SparseA = wordOfBits(A);
+    auto SparseB = wordOfBits(B);
+    Bits Xor(8192);
+    Bits And(8192);
+    Bits Sum(8192);
+    uint8_t Carry = 0;
+    for (size_t i = 0; i < 8192; i++) {
+        Xor[i] = A[i] ^ B[i];
+        And[i] = A[i] & B[i];
+        auto Total = A[i] + B[i] + Carry;
+        Sum[i] = Total & 1;
+        Carry = Total >> 1;
+    }
+    EXPECT_TRUE(bitsOf(FiniteWord_xor(SparseA, SparseB)) == Xor);
+    EXPECT_TRUE(bitsOf(FiniteWord_and(SparseA, SparseB)) == And);
+    EXPECT_TRUE(bitsOf(FiniteWord_add(SparseA, SparseB)) == Sum);
+}
+
+TEST_F(FiniteWordRuntimeTest, Repeats) {
+    // patterns that tile a limb, that do not, and that are wider than a limb
+    const size_t PatternSizes[] = { 1, 8, 7, 64, 100 };
+    for (auto PatternSize : PatternSizes) {
+        Bits PatternBits(PatternSize);
+        for (auto &Bit : PatternBits) {
+            Bit = Random() & 1;
+        }
+        auto Pattern = wordOfBits(PatternBits);
+        for (size_t Repetitions : { 1, 2, 30, 101 }) {
+            Bits Expected;
+            for (size_t i = 0; i < Repetitions; i++) {
+                Expected.insert(Expected.end(), PatternBits.begin(), PatternBits.end());
+            }
+            if (Expected.size() < 2) {
+                continue;
+            }
+            auto Repeat = FiniteWord_createFromRepsWord(Repetitions, Pattern);
+            expectSameBits(Repeat, Expected, Random);
+
+            // two repeats of patterns of the same size
+            auto Other = FiniteWord_createFromRepsWord(Repetitions, FiniteWord_not(Pattern));
+            Bits Or(Expected.size(), 1);
+            EXPECT_TRUE(bitsOf(FiniteWord_or(Repeat, Other)) == Or);
+            EXPECT_TRUE(bitsOf(FiniteWord_xor(Repeat, Other)) == Or);
+        }
+    }
+}
+
+//
+// Accumulators, which are modified in place
+//
+
+TEST_F(FiniteWordRuntimeTest, AccumulatorHash) {
+    typedef void (*Assign)(FiniteWord *, FiniteWord *);
+    typedef FiniteWord *(*Operation)(FiniteWord *, FiniteWord *);
+    const Assign Assigns[] = { FiniteWord_orAssign, FiniteWord_andAssign, FiniteWord_xorAssign, FiniteWord_addAssign, FiniteWord_multiplyAssign };
+    const Operation Operations[] = { FiniteWord_or, FiniteWord_and, FiniteWord_xor, FiniteWord_add, FiniteWord_multiply };
+    for (size_t Size : { 40, 64, 200 }) {
+        for (size_t i = 0; i < 5; i++) {
+            auto A = wordOf(randomLimbs(numLimbs(Size)), Size);
+            auto B = wordOf(randomLimbs(numLimbs(Size)), Size);
+            auto Expected = Operations[i](A, B);
+
+            // hashed before it is modified
+            auto Accumulator = FiniteWord_createAccumulator(A, Size);
+            FiniteWord_hash(Accumulator);
+            Assigns[i](Accumulator, B);
+
+            EXPECT_TRUE(FiniteWord_equal(Accumulator, Expected)) << Size << " bits, operation " << i;
+            EXPECT_EQ(FiniteWord_hash(Accumulator), FiniteWord_hash(Expected)) << Size << " bits, operation " << i;
+            FiniteWord *Both[] = { Accumulator, Expected };
+            EXPECT_FALSE(FiniteWord_arrayNotEqual(Both, 2)) << Size << " bits, operation " << i;
+        }
+    }
+}
+
+//
+// Decimal strings
+//
+
+static std::string unsignedDecimal(FiniteWord *word) {
+    char *Str;
+    FiniteWord_newDecimalString(word, &Str);
+    std::string Result(Str);
+    free(Str);
+    return Result;
+}
+
+static std::string signedDecimal(FiniteWord *word) {
+    char *Str;
+    FiniteWord_newSignedDecimalString(word, &Str);
+    std::string Result(Str);
+    free(Str);
+    return Result;
+}
+
+TEST_F(FiniteWordRuntimeTest, DecimalString) {
+    // on either side of the 19 digit fast path
+    for (auto Str : { "0", "12345", "9999999999999999999", "10000000000000000000", "18446744073709551616" }) {
+        EXPECT_EQ(Str, unsignedDecimal(FiniteWord_createFromDecimalString(64, Str)));
+    }
+
+    // short strings that are not all digits go to APInt
+    EXPECT_EQ("-12", signedDecimal(FiniteWord_createFromDecimalString(64, "-12")));
+    EXPECT_EQ("-1", signedDecimal(FiniteWord_createFromDecimalString(64, "-1")));
+    EXPECT_EQ("7", unsignedDecimal(FiniteWord_createFromDecimalString(64, "+7")));
+}
+
+//
+// Scratch allocator
+//
+
+TEST_F(FiniteWordRuntimeTest, AllocatorTrim) {
+    // large enough that the NTT scratch comes from the pooled allocator
+    const size_t Size = 64 * 100000;
+    auto A = wordOf(randomLimbs(numLimbs(Size)), Size);
+    auto B = wordOf(randomLimbs(numLimbs(Size)), Size);
+    FiniteWord_multiply(A, B);
+
+    uint64_t Allocations, Reuses, BytesMapped, BytesInUse, BytesCached;
+    FiniteWord_allocatorStats(&Allocations, &Reuses, &BytesMapped, &BytesInUse, &BytesCached);
+    EXPECT_GT(Allocations, 0u);
+    EXPECT_GT(BytesCached, 0u);
+
+    FiniteWord_allocatorTrim();
+    FiniteWord_allocatorStats(&Allocations, &Reuses, &BytesMapped, &BytesInUse, &BytesCached);
+    EXPECT_EQ(0u, BytesCached);
+    EXPECT_EQ(BytesInUse, BytesMapped);
+}
@@ -65,3 +65,37 @@ TEST(Parser, Test4) {
 //
 //    EXPECT_EQ("1", RationalWordVal->decimal());
 }
+
+/// Literals longer than 64 bits whose size is not a multiple of 64, so the
+/// lexer shifts the full limbs up past the Remainder bits read last
+TEST(Parser, LongFiniteWord) {
+    for (size_t Size : { 65, 130, 200 }) {
+        std::string Bits;
+        std::vector<uint64_t> Limbs((Size + 63) / 64, 0);
+        for (size_t i = 0; i < Size; i++) {
+            // the first digit is the most significant bit
+            auto Set = (i * i) % 7 < 3;
+            Bits += Set ? '1' : '0';
+            Limbs[(Size - 1 - i) / 64] |= static_cast<uint64_t>(Set) << ((Size - 1 - i) % 64);
+        }
+
+        std::stringstream ss;
+        ss << "`" << Bits << "`\n";
+        Parser P(ss);
+        P.readNextToken();
+        auto Parsed = P.ParseTopLevelExpression();
+        auto Def = llvm::dyn_cast<DefinitionAST>(Parsed.get());
+        auto Body = Def->getBody();
+        auto Expr = llvm::dyn_cast<FiniteWordExprAST>(Body.get());
+        ASSERT_TRUE(Expr != nullptr);
+        EXPECT_EQ("`" + Bits + "`", Expr->string());
+
+        std::stringstream Lexed;
+        Lexed << "`" << Bits << "`\n";
+        Lexer L(Lexed);
+        L.readNextToken();
+        ASSERT_EQ(tok_finiteword, L.CurTok);
+        EXPECT_EQ(Size, L.FiniteWordSize);
+        EXPECT_EQ(Limbs, L.FiniteWordLimbs);
+    }
+}
@@ -0,0 +1,252 @@
+//===------ RationalWordRuntime.test.cpp ----------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+//
+// RationalWord arithmetic through the runtime's C API
+//
+// The low K bits of a rational word are an ordinary K-bit word, and every
+// operation here commutes with taking them, so each result is checked against
+// FiniteWord arithmetic on RationalWord_residue(x, K).
+//
+
+#include "common/FiniteWord.h"
+#include "common/RationalWord.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+
+/// Bits compared for each result
+static const size_t K = 256;
+
+class RationalWordRuntimeTest : public ::testing::Test {
+protected:
+
+    RationalWordRuntimeTest() : Random(0) {}
+
+    static void SetUpTestCase() {
+        Value_initialize();
+    }
+
+    std::mt19937_64 Random;
+
+    /// Size random bits, the empty word when Size is 0
+    FiniteWord *randomWord(size_t Size) {
+        auto Builder = FiniteWordBuilder_create();
+        for (size_t Filled = 0; Filled < Size; Filled += 64) {
+            auto Count = std::min<size_t>(64, Size - Filled);
+            auto Bits = Count == 64 ? Random() : Random() & ((UINT64_C(1) << Count) - 1);
+            FiniteWordBuilder_append(Builder, FiniteWord_createFromVal(Count, Bits));
+        }
+        return FiniteWordBuilder_finish(Builder);
+    }
+
+    /// Period of 1 to MaxPeriod bits, transient of 0 to MaxTransient bits
+    RationalWord *randomRational(size_t MaxPeriod, size_t MaxTransient) {
+        auto Period = randomWord(1 + Random() % MaxPeriod);
+        auto Transient = randomWord(Random() % (MaxTransient + 1));
+        return RationalWord_createFromPeriodTransient(Period, Transient);
+    }
+};
+
+/// The low Size bits of Period repeated forever
+static FiniteWord *repeatTo(FiniteWord *Period, size_t Size) {
+    auto Repetitions = Size / FiniteWord_size(Period) + 1;
+    return FiniteWord_residue(FiniteWord_createFromRepsWord(Repetitions, Period), Size);
+}
+
+static FiniteWord *low(RationalWord *word) {
+    return RationalWord_residue(word, K);
+}
+
+TEST_F(RationalWordRuntimeTest, Bitwise) {
+    for (int i = 0; i < 120; i++) {
+        auto x = randomRational(40, 40);
+        auto y = randomRational(40, 40);
+
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_or(x, y)), FiniteWord_or(low(x), low(y))));
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_and(x, y)), FiniteWord_and(low(x), low(y))));
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_xor(x, y)), FiniteWord_xor(low(x), low(y))));
+    }
+}
+
+TEST_F(RationalWordRuntimeTest, PlusSubtractMinus) {
+    for (int i = 0; i < 120; i++) {
+        auto x = randomRational(40, 40);
+        auto y = randomRational(40, 40);
+        auto z = randomRational(40, 40);
+
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_plus(x, y)), FiniteWord_add(low(x), low(y))));
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_subtract(x, y)), FiniteWord_subtract(low(x), low(y))));
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_minus(x)), FiniteWord_minus(low(x))));
+
+        auto Chained = RationalWord_subtract(RationalWord_plus(x, y), z);
+        EXPECT_TRUE(FiniteWord_equal(low(Chained), FiniteWord_subtract(FiniteWord_add(low(x), low(y)), low(z))));
+    }
+}
+
+TEST_F(RationalWordRuntimeTest, EmptyTransients) {
+    for (int i = 0; i < 60; i++) {
+        auto x = randomRational(40, 0);
+        auto y = randomRational(40, 0);
+
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_plus(x, y)), FiniteWord_add(low(x), low(y))));
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_subtract(x, y)), FiniteWord_subtract(low(x), low(y))));
+    }
+}
+
+TEST_F(RationalWordRuntimeTest, PeriodsOfRelatedSizes) {
+    // one period a multiple of the other, and two with a common factor
+    const size_t Sizes[][2] = { { 6, 6 }, { 5, 15 }, { 12, 4 }, { 6, 10 }, { 21, 14 } };
+    for (auto &Size : Sizes) {
+        for (int i = 0; i < 20; i++) {
+            auto x = RationalWord_createFromPeriodTransient(randomWord(Size[0]), randomWord(Random() % 20));
+            auto y = RationalWord_createFromPeriodTransient(randomWord(Size[1]), randomWord(Random() % 20));
+
+            EXPECT_TRUE(FiniteWord_equal(low(RationalWord_plus(x, y)), FiniteWord_add(low(x), low(y))));
+            EXPECT_TRUE(FiniteWord_equal(low(RationalWord_subtract(x, y)), FiniteWord_subtract(low(x), low(y))));
+            EXPECT_TRUE(FiniteWord_equal(low(RationalWord_xor(x, y)), FiniteWord_xor(low(x), low(y))));
+        }
+    }
+}
+
+TEST_F(RationalWordRuntimeTest, Times) {
+    // -2 times -1
+    auto MinusTwo = RationalWord_createFromPeriodTransient(FiniteWord_ONE_1BIT, FiniteWord_ZERO_1BIT);
+    auto Two = RationalWord_createFromPeriodTransient(FiniteWord_ZERO_1BIT, FiniteWord_createFromVal(2, 2));
+    EXPECT_TRUE(RationalWord_equal(RationalWord_times(MinusTwo, RationalWord_MINUS_ONE), Two));
+
+    // short periods, so the product repeats well inside the loop limit
+    for (int i = 0; i < 120; i++) {
+        auto x = randomRational(6, 8);
+        auto y = randomRational(6, 8);
+
+        EXPECT_TRUE(FiniteWord_equal(low(RationalWord_times(x, y)), FiniteWord_multiply(low(x), low(y))));
+    }
+}
+
+TEST_F(RationalWordRuntimeTest, Identities) {
+    for (int i = 0; i < 60; i++) {
+        auto x = randomRational(60, 60);
+        auto y = randomRational(60, 60);
+
+        EXPECT_TRUE(RationalWord_equal(RationalWord_plus(RationalWord_subtract(x, y), y), x));
+        EXPECT_TRUE(RationalWord_equal(RationalWord_plus(x, RationalWord_minus(y)), RationalWord_subtract(x, y)));
+        EXPECT_TRUE(RationalWord_equal(RationalWord_plus(x, RationalWord_not(x)), RationalWord_MINUS_ONE));
+    }
+}
+
+TEST_F(RationalWordRuntimeTest, WidePeriods) {
+    // coprime sizes, so the periodic parts are combined over about a million bits
+    auto x = RationalWord_createFromPeriodTransient(randomWord(1009), randomWord(30));
+    auto y = RationalWord_createFromPeriodTransient(randomWord(1013), randomWord(70));
+
+    auto Sum = RationalWord_plus(x, y);
+    EXPECT_TRUE(FiniteWord_equal(low(Sum), FiniteWord_add(low(x), low(y))));
+    EXPECT_TRUE(FiniteWord_equal(low(RationalWord_or(x, y)), FiniteWord_or(low(x), low(y))));
+    EXPECT_TRUE(RationalWord_equal(RationalWord_subtract(Sum, y), x));
+}
+
+TEST_F(RationalWordRuntimeTest, PeriodicCombine) {
+    for (int i = 0; i < 120; i++) {
+        auto A = randomWord(1 + Random() % 40);
+        auto B = randomWord(1 + Random() % 40);
+        auto RepeatedA = repeatTo(A, K);
+        auto RepeatedB = repeatTo(B, K);
+
+        EXPECT_TRUE(FiniteWord_equal(repeatTo(FiniteWord_periodOr(A, B), K), FiniteWord_or(RepeatedA, RepeatedB)));
+        EXPECT_TRUE(FiniteWord_equal(repeatTo(FiniteWord_periodAnd(A, B), K), FiniteWord_and(RepeatedA, RepeatedB)));
+        EXPECT_TRUE(FiniteWord_equal(repeatTo(FiniteWord_periodXor(A, B), K), FiniteWord_xor(RepeatedA, RepeatedB)));
+
+        uint8_t Carry = Random() % 2;
+        FiniteWord *Prefix;
+        FiniteWord *Period;
+        FiniteWord_periodPlus(A, B, Carry, &Prefix, &Period);
+        auto Sum = RationalWord_createFromPeriodTransient(Period, Prefix);
+        auto Expected = FiniteWord_add(FiniteWord_add(RepeatedA, RepeatedB), FiniteWord_createFromVal(K, Carry));
+        EXPECT_TRUE(FiniteWord_equal(low(Sum), Expected));
+    }
+}
+
+/// Sum of periods A and B plus Carry, by the closed form with its cost check
+/// off, equals the streamed one
+static void expectClosedFormPlus(FiniteWord *A, FiniteWord *B, uint8_t Carry) {
+    FiniteWord *Prefix;
+    FiniteWord *Period;
+    EXPECT_TRUE(RationalWord_closedFormPeriodPlus(A, B, Carry, false, &Prefix, &Period));
+    FiniteWord *StreamPrefix;
+    FiniteWord *StreamPeriod;
+    FiniteWord_periodPlus(A, B, Carry, &StreamPrefix, &StreamPeriod);
+    EXPECT_TRUE(RationalWord_equal(RationalWord_createFromPeriodTransient(Period, Prefix), RationalWord_createFromPeriodTransient(StreamPeriod, StreamPrefix)));
+    EXPECT_EQ(FiniteWord_size(Period), FiniteWord_size(StreamPeriod));
+}
+
+/// Size bits, with only bit Position set
+static FiniteWord *singleBit(size_t Size, size_t Position) {
+    return FiniteWord_leftShift(FiniteWord_createFromVal(Size, 1), Position);
+}
+
+TEST_F(RationalWordRuntimeTest, ClosedFormCollapse) {
+    // periods of 101 and 7 bits give 707, 7 and 103 give 721, and the sum of
+    // those cancels y, repeating every 101 * 103 bits instead of every
+    // lcm(707, 721) = 72821
+    auto x = RationalWord_createFromPeriodTransient(randomWord(101), randomWord(13));
+    auto y = RationalWord_createFromPeriodTransient(randomWord(7), randomWord(40));
+    auto z = RationalWord_createFromPeriodTransient(randomWord(103), randomWord(5));
+    auto A = RationalWord_plus(x, y);
+    auto B = RationalWord_subtract(z, y);
+    ASSERT_EQ(FiniteWord_size(RationalWord_period(A)), 707u);
+    ASSERT_EQ(FiniteWord_size(RationalWord_period(B)), 721u);
+
+    // the cost model takes the closed form at these sizes
+    FiniteWord *Prefix;
+    FiniteWord *Period;
+    EXPECT_TRUE(RationalWord_closedFormPeriodPlus(RationalWord_period(A), RationalWord_period(B), 0, true, &Prefix, &Period));
+
+    auto Sum = RationalWord_plus(A, B);
+    EXPECT_TRUE(RationalWord_equal(Sum, RationalWord_plus(x, z)));
+    EXPECT_EQ(FiniteWord_size(RationalWord_period(Sum)), 10403u);
+    EXPECT_TRUE(FiniteWord_equal(low(Sum), FiniteWord_add(low(x), low(z))));
+}
+
+TEST_F(RationalWordRuntimeTest, ClosedFormCarries) {
+    // small periods sum to less than 1 in magnitude, with no carry out of them
+    auto SmallA = singleBit(6, 2);
+    auto SmallB = singleBit(10, 7);
+    // mostly 1 bits, which sum to less than -1
+    auto LargeA = FiniteWord_not(SmallA);
+    auto LargeB = FiniteWord_not(SmallB);
+
+    // the carry is taken in whole, or one 2^q - 1 is taken out of the period,
+    // or both, so that the period fits in q bits
+    expectClosedFormPlus(SmallA, SmallB, 0);
+    expectClosedFormPlus(SmallA, SmallB, 1);
+    expectClosedFormPlus(LargeA, LargeB, 0);
+    expectClosedFormPlus(LargeA, LargeB, 1);
+}
+
+TEST_F(RationalWordRuntimeTest, ClosedFormIntegerSum) {
+    // sums that are integers, where V is 1 once the gcd is divided out
+    auto P = randomWord(12);
+    expectClosedFormPlus(P, FiniteWord_not(P), 0);
+    expectClosedFormPlus(P, FiniteWord_not(P), 1);
+    auto Zeros = FiniteWord_createFromVal(6, 0);
+    expectClosedFormPlus(Zeros, FiniteWord_createFromVal(10, 0), 1);
+    auto Ones = FiniteWord_not(Zeros);
+    expectClosedFormPlus(Ones, FiniteWord_not(FiniteWord_createFromVal(10, 0)), 0);
+}
+
+TEST_F(RationalWordRuntimeTest, ClosedFormRandom) {
+    for (int i = 0; i < 120; i++) {
+        auto A = randomWord(1 + Random() % 40);
+        auto B = randomWord(1 + Random() % 40);
+        expectClosedFormPlus(A, B, Random() % 2);
+    }
+}
@@ -0,0 +1,234 @@
+//===------ WordVectorRuntime.test.cpp ------------------------------------===//
+//
+// The Tuppence Programming Language
+//
+// This file is distributed under the MIT Open Source License.
+// See LICENSE for details.
+//
+//===----------------------------------------------------------------------===//
+
+//
+// WordVector through the runtime's C API
+//
+// Every elementwise operation is checked word by word against the FiniteWord
+// operation it stands for, at widths around the limb boundaries and at counts
+// that do not fill the last group of 64 lanes.
+//
+
+#include "common/FiniteWord.h"
+#include "common/List.h"
+#include "common/WordVector.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const size_t Widths[] = { 1, 8, 63, 64, 65, 127, 128, 129, 200 };
+static const size_t Counts[] = { 1, 5, 63, 64, 65, 130 };
+
+class WordVectorRuntimeTest : public ::testing::Test {
+protected:
+
+    WordVectorRuntimeTest() : Random(0) {}
+
+    static void SetUpTestCase() {
+        Value_initialize();
+    }
+
+    std::mt19937_64 Random;
+
+    FiniteWord *randomWord(size_t Size) {
+        auto Builder = FiniteWordBuilder_create();
+        for (size_t Filled = 0; Filled < Size; Filled += 64) {
+            auto Count = std::min<size_t>(64, Size - Filled);
+            auto Bits = Count == 64 ? Random() : Random() & ((UINT64_C(1) << Count) - 1);
+            FiniteWordBuilder_append(Builder, FiniteWord_createFromVal(Count, Bits));
+        }
+        return FiniteWordBuilder_finish(Builder);
+    }
+
+    std::vector<FiniteWord *> randomWords(size_t Width, size_t Count) {
+        std::vector<FiniteWord *> Words;
+        for (size_t i = 0; i < Count; i++) {
+            Words.push_back(randomWord(Width));
+        }
+        return Words;
+    }
+};
+
+/// Each word of Vector is the matching word of Words
+static void expectWords(WordVector *Vector, const std::vector<FiniteWord *> &Words) {
+    ASSERT_EQ(Words.size(), WordVector_count(Vector));
+    for (size_t i = 0; i < Words.size(); i++) {
+        EXPECT_EQ(FiniteWord_size(Words[i]), WordVector_width(Vector));
+        EXPECT_TRUE(FiniteWord_equal(WordVector_get(Vector, i), Words[i])) << "word " << i;
+    }
+}
+
+TEST_F(WordVectorRuntimeTest, RoundTrip) {
+    for (auto Width : Widths) {
+        for (auto Count : Counts) {
+            SCOPED_TRACE(testing::Message() << "width " << Width << " count " << Count);
+            auto Words = randomWords(Width, Count);
+            auto Vector = WordVector_createFromWords(Words.data(), Count);
+            EXPECT_EQ(Width, WordVector_width(Vector));
+            expectWords(Vector, Words);
+
+            // list(vector(...)) and vector(list(...))
+            auto Listed = WordVector_toList(Vector);
+            ASSERT_EQ(Count, List_size(Listed));
+            for (size_t i = 0; i < Count; i++) {
+                auto Val = List_get(Listed, i);
+                ASSERT_EQ(FiniteWordTag, Val->tag);
+                EXPECT_TRUE(FiniteWord_equal(Val->finite, Words[i]));
+            }
+            auto Again = WordVector_createFromList(Listed);
+            ASSERT_NE(nullptr, Again);
+            expectWords(Again, Words);
+        }
+    }
+}
+
+TEST_F(WordVectorRuntimeTest, CreateFromListRejects) {
+    EXPECT_EQ(nullptr, WordVector_createFromList(List_createEmpty()));
+
+    TuppenceValue *Mixed[] = {
+        Value_createFromFiniteWord(randomWord(64)),
+        Value_createFromFiniteWord(randomWord(65)),
+    };
+    EXPECT_EQ(nullptr, WordVector_createFromList(List_createFromVals(Mixed, 2)));
+}
+
+TEST_F(WordVectorRuntimeTest, Bitwise) {
+    for (auto Width : Widths) {
+        for (auto Count : Counts) {
+            SCOPED_TRACE(testing::Message() << "width " << Width << " count " << Count);
+            std::vector<FiniteWord *> Words[3];
+            WordVector *Vectors[3];
+            for (size_t k = 0; k < 3; k++) {
+                Words[k] = randomWords(Width, Count);
+                Vectors[k] = WordVector_createFromWords(Words[k].data(), Count);
+            }
+            auto Or = WordVector_arrayOr(Vectors, 3);
+            auto And = WordVector_arrayAnd(Vectors, 3);
+            auto Xor = WordVector_arrayXor(Vectors, 3);
+            for (size_t i = 0; i < Count; i++) {
+                FiniteWord *Column[] = { Words[0][i], Words[1][i], Words[2][i] };
+                EXPECT_TRUE(FiniteWord_equal(WordVector_get(Or, i), FiniteWord_arrayOr(Column, 3)));
+                EXPECT_TRUE(FiniteWord_equal(WordVector_get(And, i), FiniteWord_arrayAnd(Column, 3)));
+                EXPECT_TRUE(FiniteWord_equal(WordVector_get(Xor, i), FiniteWord_arrayXor(Column, 3)));
+            }
+        }
+    }
+}
+
+TEST_F(WordVectorRuntimeTest, Plus) {
+    for (auto Width : Widths) {
+        for (auto Count : Counts) {
+            for (size_t Operands : { 2, 3, 5 }) {
+                SCOPED_TRACE(testing::Message() << "width " << Width << " count " << Count << " operands " << Operands);
+                std::vector<std::vector<FiniteWord *>> Words;
+                std::vector<WordVector *> Vectors;
+                for (size_t k = 0; k < Operands; k++) {
+                    Words.push_back(randomWords(Width, Count));
+                    Vectors.push_back(WordVector_createFromWords(Words[k].data(), Count));
+                }
+                WordVector *Hi;
+                WordVector *Lo;
+                WordVector_arrayPlus(Vectors.data(), Operands, &Hi, &Lo);
+                for (size_t i = 0; i < Count; i++) {
+                    std::vector<FiniteWord *> Column;
+                    for (size_t k = 0; k < Operands; k++) {
+                        Column.push_back(Words[k][i]);
+                    }
+                    FiniteWord *WordHi;
+                    FiniteWord *WordLo;
+                    FiniteWord_arrayPlus(Column.data(), Operands, &WordHi, &WordLo);
+                    EXPECT_TRUE(FiniteWord_equal(WordVector_get(Hi, i), WordHi)) << "word " << i;
+                    EXPECT_TRUE(FiniteWord_equal(WordVector_get(Lo, i), WordLo)) << "word " << i;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(WordVectorRuntimeTest, Subtract) {
+    for (auto Width : Widths) {
+        for (auto Count : Counts) {
+            SCOPED_TRACE(testing::Message() << "width " << Width << " count " << Count);
+            auto Left = randomWords(Width, Count);
+            auto Right = randomWords(Width, Count);
+            // equal words, where nothing is borrowed
+            Right[0] = Left[0];
+            WordVector *Vectors[] = {
+                WordVector_createFromWords(Left.data(), Count),
+                WordVector_createFromWords(Right.data(), Count),
+            };
+            WordVector *Hi;
+            WordVector *Lo;
+            WordVector_arraySubtract(Vectors, 2, &Hi, &Lo);
+            for (size_t i = 0; i < Count; i++) {
+                FiniteWord *Column[] = { Left[i], Right[i] };
+                FiniteWord *WordHi;
+                FiniteWord *WordLo;
+                FiniteWord_arraySubtract(Column, 2, &WordHi, &WordLo);
+                EXPECT_TRUE(FiniteWord_equal(WordVector_get(Hi, i), WordHi)) << "word " << i;
+                EXPECT_TRUE(FiniteWord_equal(WordVector_get(Lo, i), WordLo)) << "word " << i;
+            }
+        }
+    }
+}
+
+TEST_F(WordVectorRuntimeTest, CountPopulation) {
+    for (auto Width : Widths) {
+        for (auto Count : Counts) {
+            SCOPED_TRACE(testing::Message() << "width " << Width << " count " << Count);
+            auto Words = randomWords(Width, Count);
+            auto Vector = WordVector_createFromWords(Words.data(), Count);
+            auto Population = WordVector_countPopulation(Vector);
+            for (size_t i = 0; i < Count; i++) {
+                auto Expected = FiniteWord_createFromVal(WordVector_width(Population), FiniteWord_countPopulation(Words[i]));
+                EXPECT_TRUE(FiniteWord_equal(WordVector_get(Population, i), Expected)) << "word " << i;
+            }
+        }
+    }
+}
+
+TEST_F(WordVectorRuntimeTest, Equality) {
+    for (auto Width : Widths) {
+        for (auto Count : Counts) {
+            SCOPED_TRACE(testing::Message() << "width " << Width << " count " << Count);
+            std::vector<FiniteWord *> Words[3];
+            Words[0] = randomWords(Width, Count);
+            Words[1] = randomWords(Width, Count);
+            Words[2] = randomWords(Width, Count);
+            // lanes where all, some, or none of the words are equal
+            for (size_t i = 0; i < Count; i++) {
+                switch (i % 3) {
+                case 0:
+                    Words[1][i] = Words[0][i];
+                    Words[2][i] = Words[0][i];
+                    break;
+                case 1:
+                    Words[2][i] = Words[0][i];
+                    break;
+                }
+            }
+            WordVector *Vectors[3];
+            for (size_t k = 0; k < 3; k++) {
+                Vectors[k] = WordVector_createFromWords(Words[k].data(), Count);
+            }
+            auto Equal = WordVector_arrayEqual(Vectors, 3);
+            auto NotEqual = WordVector_arrayNotEqual(Vectors, 3);
+            for (size_t i = 0; i < Count; i++) {
+                FiniteWord *Column[] = { Words[0][i], Words[1][i], Words[2][i] };
+                auto ExpectedEqual = FiniteWord_createFromVal(1, FiniteWord_arrayEqual(Column, 3));
+                auto ExpectedNotEqual = FiniteWord_createFromVal(1, FiniteWord_arrayNotEqual(Column, 3));
+                EXPECT_TRUE(FiniteWord_equal(WordVector_get(Equal, i), ExpectedEqual)) << "word " << i;
+                EXPECT_TRUE(FiniteWord_equal(WordVector_get(NotEqual, i), ExpectedNotEqual)) << "word " << i;
+            }
+        }
+    }
+}